@@ -0,0 +1,298 @@
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <unistd.h>
+#include "consts.hh"
+#include "exceptions.hh"
+#include "match.hh"
+#include "memory.hh"
+#include "reader.hh"
+#include "record.hh"
+#include "types.hh"
+#include "unit.hh"
+#include "writer.hh"
+using namespace std;
+
+// Benchmarks the simulator hot paths and prints one tab separated row per
+// benchmark (the check column is OK or FAIL when there is something to check)
+
+using Clock = chrono::steady_clock;
+
+struct Expectation {
+    String label;
+    u64 access_count;
+    u64 hit_count;
+    u64 miss_count;
+};
+
+const u64 DEFAULT_ACCESSES = 2 * 1024 * 1024;
+const u64 LARGE_ACCESSES = 8 * 1024 * 1024;
+const u32 SEED = 0;
+const u32 STORE_PERCENT = 30;
+const char *TESTS[] = {"t1", "t2", "t3"};
+
+f64 seconds_since(Clock::time_point start) {
+    return chrono::duration<f64>(Clock::now() - start).count();
+}
+
+void row(const String &name, u64 count, f64 seconds, const String &check) {
+    cout << name << "\t" << count << "\t" << seconds << "\t"
+        << (u64)(seconds > 0 ? count / seconds : 0) << "\t" << check << "\n";
+    cout.flush();
+}
+
+String temporary(const String &suffix) {
+    // A fresh path in the temporary directory
+    auto *dir = getenv("TMPDIR");
+    auto sb = StringBuilder();
+    sb << (dir != NULL ? dir : "/tmp") << "/cachesim-bench-" << getpid() << "-" << suffix;
+    return sb.str();
+}
+
+String write_conf(const String &name, const String &way, const String &size) {
+    // One level of the given organisation in front of main memory
+    auto path = temporary(name + ".conf");
+    auto file = FileWriter(path);
+    file << "Level:L1\nLine:64\nWay:" << way << "\nSize:" << size << "\nHitTime:4\n"
+        << "WritePolicy:WriteBack\nAllocationPolicy:WriteAllocate\n"
+        << "Level:Main\nHitTime:100\n";
+    file.close();
+    return path;
+}
+
+Vector<Record> generate(const String &pattern, u64 count) {
+    // Fixed seed access patterns: 'sequential' walks 8 byte words through
+    // 64M, 'local' picks words at random in 256K and 'random' picks any
+    // address
+    auto records = Vector<Record>(count);
+    mt19937 rng(SEED);
+    uniform_int_distribution<u32> any;
+    uniform_int_distribution<u32> percent(0, 99);
+    for (u64 i = 0; i < count; i++) {
+        if (pattern == "sequential") {
+            records[i].address = (u32)((i * 8) % (64 * 1024 * 1024));
+        } else if (pattern == "local") {
+            records[i].address = (any(rng) % (256 * 1024)) & ~7U;
+        } else {
+            records[i].address = any(rng);
+        }
+        records[i].store = percent(rng) < STORE_PERCENT;
+        records[i].core = 0;
+    }
+    return records;
+}
+
+void write_text(const String &path, const Vector<Record> &records) {
+    auto file = FileWriter(path);
+    for (auto &record: records) {
+        file << (record.store ? "st " : "ld ") << record.address << "\n";
+    }
+    file.close();
+}
+
+void write_trace(const String &path, const Vector<Record> &records) {
+    Writer writer(path);
+    writer.write(records.data(), records.size());
+    writer.close();
+}
+
+Vector<Expectation> expectations(const String &path, u64 &time) {
+    // The summary at the end of 'test/*/out' ('Level:', 'Access:', 'Hit:'
+    // and 'Miss:' lines per level and the 'TotalTime:', the access log before
+    // it is skipped)
+    auto result = Vector<Expectation>();
+    auto file = FileReader(path);
+    String line;
+    while (getline(file, line)) {
+        auto colon = line.find(':');
+        if (line.empty() || line[0] == '[' || colon == String::npos) {
+            continue;
+        }
+        auto key = line.substr(0, colon);
+        auto value = line.substr(colon + 1);
+        if (key == "Level") {
+            result.push_back(Expectation{value, 0, 0, 0});
+        } else if (key == "TotalTime") {
+            time = stoull(value);
+        } else if (result.empty()) {
+            continue;
+        } else if (key == "Access") {
+            result.back().access_count = stoull(value);
+        } else if (key == "Hit") {
+            result.back().hit_count = stoull(value);
+        } else if (key == "Miss") {
+            result.back().miss_count = stoull(value);
+        }
+    }
+    return result;
+}
+
+bool matches(Memory &memory, const Vector<Expectation> &expected, u64 time) {
+    if (memory.get_unit()->get_access_time() != time) {
+        return false;
+    }
+    u64 i = 0;
+    for (auto *unit = memory.get_unit(); unit != NULL; unit = unit->get_next(), i++) {
+        if (
+            i >= expected.size() ||
+            unit->get_label() != expected[i].label ||
+            unit->get_hit_count() != expected[i].hit_count ||
+            unit->get_miss_count() != expected[i].miss_count ||
+            unit->get_hit_count() + unit->get_miss_count() != expected[i].access_count
+        ) {
+            return false;
+        }
+    }
+    return i == expected.size();
+}
+
+void bench_organisations(u64 count) {
+    // Accesses per second through 'Memory::exec' (records already decoded)
+    const char *organisations[][2] = {{"direct", "1"}, {"set", "8"}, {"full", "Full"}};
+    const char *sizes[] = {"32K", "2M"};
+    const char *patterns[] = {"sequential", "local", "random"};
+    for (auto *pattern: patterns) {
+        auto records = generate(pattern, count);
+        for (auto &organisation: organisations) {
+            for (auto *size: sizes) {
+                auto name = String("exec/") + organisation[0] + "/" + size + "/" + pattern;
+                auto conf = write_conf("exec", organisation[1], size);
+                Memory memory;
+                memory.conf(conf);
+                remove(conf.c_str());
+                auto start = Clock::now();
+                memory.exec(records.data(), records.size());
+                row(name, count, seconds_since(start), "-");
+            }
+        }
+    }
+}
+
+void bench_ways(u64 count) {
+    // Highly associative sets with every tag match kernel the processor
+    // supports (checked against the scalar counters)
+    const char *ways[] = {"16", "32", "64"};
+    u8 kernels[] = {consts::SCALAR, consts::SSE2, consts::AVX2};
+    const char *names[] = {"scalar", "sse2", "avx2"};
+    auto best = match::get_kernel();
+    auto records = generate("random", count);
+    for (auto *way: ways) {
+        u64 hits = 0;
+        for (u32 i = 0; i < 3; i++) {
+            if (!match::is_supported(kernels[i])) {
+                continue;
+            }
+            match::select(kernels[i]);
+            auto conf = write_conf("ways", way, "2M");
+            Memory memory;
+            memory.conf(conf);
+            remove(conf.c_str());
+            auto start = Clock::now();
+            memory.exec(records.data(), records.size());
+            auto seconds = seconds_since(start);
+            if (i == 0) {
+                hits = memory.get_unit()->get_hit_count();
+            }
+            auto check = memory.get_unit()->get_hit_count() == hits;
+            row(String("ways/") + way + "/" + names[i], count, seconds, check ? "OK" : "FAIL");
+        }
+    }
+    match::select(best);
+}
+
+void bench_parse(u64 count) {
+    // Records per second through the reader alone, for both file formats
+    auto records = generate("random", count);
+    auto text = temporary("parse.acc");
+    auto trace = temporary("parse.trc");
+    write_text(text, records);
+    write_trace(trace, records);
+    String names[] = {"parse/text", "parse/binary"};
+    String paths[] = {text, trace};
+    for (u32 i = 0; i < 2; i++) {
+        auto batch = Vector<Record>(consts::BATCH_SIZE);
+        auto start = Clock::now();
+        Reader reader(paths[i]);
+        u64 total = 0;
+        u64 checksum = 0;
+        while (auto n = reader.read(batch.data(), batch.size())) {
+            for (u64 j = 0; j < n; j++) {
+                checksum += batch[j].address + batch[j].store;
+            }
+            total += n;
+        }
+        auto seconds = seconds_since(start);
+        u64 expected = 0;
+        for (auto &record: records) {
+            expected += record.address + record.store;
+        }
+        row(names[i], total, seconds, total == count && checksum == expected ? "OK" : "FAIL");
+    }
+    remove(text.c_str());
+    remove(trace.c_str());
+}
+
+bool bench_tests(u64 count) {
+    // End to end ('Memory::access') on the provided tests, checked against
+    // their expected output, then on a large generated trace per test conf
+    bool okay = true;
+    for (auto *test: TESTS) {
+        auto conf = String("test/") + test + "/conf";
+        auto access = String("test/") + test + "/access";
+        u64 time = 0;
+        auto expected = expectations(String("test/") + test + "/out", time);
+        Memory memory;
+        memory.conf(conf);
+        auto start = Clock::now();
+        memory.access(access);
+        auto seconds = seconds_since(start);
+        auto check = matches(memory, expected, time);
+        okay = okay && check;
+        row(String("test/") + test, memory.get_unit()->get_hit_count() + memory.get_unit()->get_miss_count(), seconds, check ? "OK" : "FAIL");
+    }
+    auto records = generate("local", count / 2);
+    auto spread = generate("random", count / 2);
+    records.insert(records.end(), spread.begin(), spread.end());
+    String paths[] = {temporary("large.acc"), temporary("large.trc")};
+    String formats[] = {"text", "binary"};
+    write_text(paths[0], records);
+    write_trace(paths[1], records);
+    for (auto *test: TESTS) {
+        auto conf = String("test/") + test + "/conf";
+        for (u32 i = 0; i < 2; i++) {
+            Memory memory;
+            memory.conf(conf);
+            auto start = Clock::now();
+            memory.access(paths[i]);
+            row(String("large/") + test + "/" + formats[i], records.size(), seconds_since(start), "-");
+        }
+    }
+    remove(paths[0].c_str());
+    remove(paths[1].c_str());
+    return okay;
+}
+
+int main(int argc, char *argv[]) {
+    // An optional argument overrides the accesses per benchmark
+    auto count = DEFAULT_ACCESSES;
+    auto large = LARGE_ACCESSES;
+    if (argc > 1) {
+        count = stoull(argv[1]);
+        large = count * 4;
+    }
+    cout << "Benchmark\tAccessCount\tSeconds\tAccessesPerSecond\tCheck\n";
+    try {
+        bench_organisations(count);
+        bench_ways(count);
+        bench_parse(large);
+        if (!bench_tests(large)) {
+            cerr << "counters differ from the expected test output" << endl;
+            return 1;
+        }
+    } catch (RuntimeException &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
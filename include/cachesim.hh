@@ -0,0 +1,64 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class Memory;
+class Unit;
+
+// Public interface of libcachesim. Errors are reported by throwing
+// std::runtime_error with the same messages as the command line.
+namespace cachesim {
+    // A single access, laid out exactly like the simulator's own records so
+    // batches are simulated in place (the core only matters to hierarchies
+    // with private levels)
+    struct Access {
+        uint64_t address;
+        bool store;
+        uint16_t core;
+    };
+
+    // One level of the hierarchy ('way' 0 is fully associative and the
+    // label "Main" is main memory, which only uses 'hit_time')
+    struct Level {
+        std::string label;
+        uint32_t line;
+        uint32_t way;
+        uint64_t size;
+        uint32_t hit_time;
+        bool write_back;
+        bool write_allocate;
+        std::string replacement;
+    };
+
+    // The counters of one level (private levels are labelled with their
+    // core, e.g. "C1.L1")
+    struct Counters {
+        std::string label;
+        uint64_t hit_count;
+        uint64_t miss_count;
+        uint64_t eviction_count;
+        uint64_t writeback_count;
+        uint64_t access_time;
+    };
+
+    class Simulator {
+        private:
+            Memory *memory;
+            void build(const std::string&);
+            void require_single();
+            void add_counters(std::vector<Counters>&, Unit*, const std::string&);
+
+        public:
+            Simulator(const std::string&);
+            Simulator(const std::vector<Level>&);
+            ~Simulator();
+            Simulator(const Simulator&) = delete;
+            Simulator& operator=(const Simulator&) = delete;
+            void access(const Access*, uint64_t);
+            uint32_t load(uint64_t);
+            uint32_t store(uint64_t);
+            void reset();
+            std::vector<Counters> get_counters();
+    };
+}
@@ -0,0 +1,76 @@
+#include "associativity.hh"
+#include "types.hh"
+
+Associativity::Associativity(u32 set_bits, u32 way) {
+    this->set_bits = set_bits;
+    this->way = way;
+    this->access_count = 0;
+
+    // One LRU stack of 'way' lines per set for every power of two set count
+    // from one to 2^set_bits (laid out one set count after another)
+    this->offsets = Vector<u64>();
+    u64 sets = 0;
+    for (u32 bits = 0; bits <= set_bits; bits++) {
+        this->offsets.push_back(sets);
+        sets += 1ULL << bits;
+    }
+    this->lines = Vector<u64>(sets * way, 0);
+    this->fills = Vector<u32>(sets, 0);
+    this->histogram = Vector<u64>((set_bits + 1) * (u64)way, 0);
+}
+
+void Associativity::touch(u64 line) {
+    // LRU is a stack algorithm, so the depth of the line in its set's stack
+    // decides hit or miss for every associativity at once (every set count
+    // is simulated separately but in the same pass)
+    this->access_count += 1;
+    for (u32 bits = 0; bits <= this->set_bits; bits++) {
+        auto set = this->offsets[bits] + (line & ((1ULL << bits) - 1));
+        auto *stack = &this->lines[set * this->way];
+        auto &fill = this->fills[set];
+        u32 depth = 0;
+        while (depth < fill && stack[depth] != line) {
+            depth++;
+        }
+        if (depth < fill) {
+            // Hit in every cache with more than 'depth' ways
+            this->histogram[bits * this->way + depth] += 1;
+        } else if (fill < this->way) {
+            // Miss in every cache (the stack still has room)
+            fill += 1;
+        } else {
+            // Miss in every cache (the deepest line falls off)
+            depth -= 1;
+        }
+        for (; depth > 0; depth--) {
+            stack[depth] = stack[depth - 1];
+        }
+        stack[0] = line;
+    }
+}
+
+u32 Associativity::get_set_bits() {
+    return this->set_bits;
+}
+
+u32 Associativity::get_way() {
+    return this->way;
+}
+
+u64 Associativity::get_access_count() {
+    return this->access_count;
+}
+
+u64 Associativity::get_hit_count(u32 set_bits, u32 way) {
+    u64 count = 0;
+    for (u32 depth = 0; depth < way && depth < this->way; depth++) {
+        count += this->histogram[set_bits * this->way + depth];
+    }
+    return count;
+}
+
+void Associativity::reset() {
+    // Keep the simulated sets so the next accesses see them warm
+    this->access_count = 0;
+    this->histogram.assign(this->histogram.size(), 0);
+}
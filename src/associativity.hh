@@ -0,0 +1,22 @@
+#pragma once
+#include "types.hh"
+
+class Associativity {
+    private:
+        u32 set_bits;
+        u32 way;
+        u64 access_count;
+        Vector<u64> lines;
+        Vector<u32> fills;
+        Vector<u64> offsets;
+        Vector<u64> histogram;
+
+    public:
+        Associativity(u32, u32);
+        void reset();
+        void touch(u64);
+        u32 get_set_bits();
+        u32 get_way();
+        u64 get_access_count();
+        u64 get_hit_count(u32, u32);
+};
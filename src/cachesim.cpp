@@ -0,0 +1,129 @@
+#include <cstddef>
+#include "cachesim.hh"
+#include "chars.hh"
+#include "config.hh"
+#include "exceptions.hh"
+#include "memory.hh"
+#include "record.hh"
+#include "text.hh"
+#include "types.hh"
+#include "unit.hh"
+
+// Batches are passed to the engines without copying
+static_assert(sizeof(cachesim::Access) == sizeof(Record), "'Access' must match 'Record'");
+static_assert(offsetof(cachesim::Access, address) == offsetof(Record, address), "'Access' must match 'Record'");
+static_assert(offsetof(cachesim::Access, store) == offsetof(Record, store), "'Access' must match 'Record'");
+static_assert(offsetof(cachesim::Access, core) == offsetof(Record, core), "'Access' must match 'Record'");
+
+namespace cachesim {
+    Simulator::Simulator(const String &conf) {
+        this->memory = NULL;
+        this->build(conf);
+    }
+
+    Simulator::Simulator(const Vector<Level> &levels) {
+        // Describe the levels in the configuration format (which ignores case)
+        auto sb = StringBuilder();
+        for (auto &level: levels) {
+            auto label = String();
+            for (auto c: level.label) {
+                label.push_back(chars::normalize(c));
+            }
+            sb << text::LEVEL << ":" << label << "\n";
+            if (label.compare(text::MAIN) == 0) {
+                sb << text::HIT_TIME << ":" << level.hit_time << "\n";
+                continue;
+            }
+            sb << text::LINE << ":" << level.line << "\n"
+                << text::WAY << ":" << (level.way == 0 ? text::FULL : std::to_string(level.way)) << "\n"
+                << text::SIZE << ":" << level.size << "\n"
+                << text::HIT_TIME << ":" << level.hit_time << "\n"
+                << text::WRITE_POLICY << ":" << (level.write_back ? text::WRITE_BACK : text::WRITE_THROUGH) << "\n"
+                << text::ALLOC_POLICY << ":" << (level.write_allocate ? text::WRITE_ALLOCATE_ON : text::WRITE_ALLOCATE_OFF) << "\n";
+            if (!level.replacement.empty()) {
+                sb << text::REPLACEMENT << ":" << level.replacement << "\n";
+            }
+        }
+        this->memory = NULL;
+        this->build(sb.str());
+    }
+
+    Simulator::~Simulator() {
+        if (this->memory != NULL) {
+            delete this->memory;
+        }
+    }
+
+    void Simulator::build(const String &conf) {
+        auto config = Config();
+        config.parse_text(conf);
+        if (config.size() > 1) {
+            throw FormatException("'conf' describes a sweep");
+        }
+        auto *memory = new Memory();
+        try {
+            memory->conf(config, 0);
+            if (!memory->is_feasible()) {
+                throw FormatException("configuration is not feasible");
+            }
+        } catch (...) {
+            delete memory;
+            throw;
+        }
+        this->memory = memory;
+    }
+
+    void Simulator::access(const Access *accesses, u64 count) {
+        this->memory->exec((const Record*)accesses, count);
+    }
+
+    u32 Simulator::load(u64 address) {
+        this->require_single();
+        return this->memory->get_unit()->load(address);
+    }
+
+    u32 Simulator::store(u64 address) {
+        this->require_single();
+        return this->memory->get_unit()->store(address);
+    }
+
+    void Simulator::require_single() {
+        // Single accesses don't say which core made them
+        if (this->memory->get_core_count() > 0) {
+            throw RuntimeException("multi-core hierarchies only accept batches");
+        }
+    }
+
+    void Simulator::reset() {
+        // Clear the counters, keeping the lines
+        this->memory->reset();
+    }
+
+    Vector<Counters> Simulator::get_counters() {
+        // Every core's private levels (labelled with their core) come before
+        // the shared levels
+        auto counters = Vector<Counters>();
+        for (u32 core = 0; core < this->memory->get_core_count(); core++) {
+            for (auto *unit = this->memory->get_core(core); unit->get_next() != NULL; unit = unit->get_next()) {
+                this->add_counters(counters, unit, "C" + std::to_string(core) + ".");
+            }
+        }
+        for (auto *unit = this->memory->get_unit(); unit != NULL; unit = unit->get_next()) {
+            this->add_counters(counters, unit, "");
+        }
+        return counters;
+    }
+
+    void Simulator::add_counters(Vector<Counters> &counters, Unit *unit, const String &prefix) {
+        counters.push_back(
+            Counters{
+                prefix + unit->get_label(),
+                unit->get_hit_count(),
+                unit->get_miss_count(),
+                unit->get_eviction_count(),
+                unit->get_writeback_count(),
+                unit->get_access_time()
+            }
+        );
+    }
+}
@@ -8,6 +8,25 @@ bool chars::is_alphanum(char c) {
     );
 }
 
+bool chars::is_blank(char c) {
+    return c == chars::SPACE || c == chars::TAB || c == chars::CR;
+}
+
+bool chars::is_digit(char c) {
+    return c >= chars::NUM_0 && c <= chars::NUM_9;
+}
+
+i8 chars::hex_value(char c) {
+    if (c >= chars::NUM_0 && c <= chars::NUM_9) {
+        return c - chars::NUM_0;
+    } else if (c >= chars::UPPER_A && c <= chars::UPPER_F) {
+        return c - chars::UPPER_A + 10;
+    } else if (c >= chars::LOWER_A && c <= chars::LOWER_F) {
+        return c - chars::LOWER_A + 10;
+    }
+    return -1;
+}
+
 char chars::normalize(char c) {
     if (c >= chars::LOWER_A && c <= chars::LOWER_Z) {
         return c - 32;
@@ -2,19 +2,36 @@
 #include "types.hh"
 
 namespace chars {
+    const char TAB = 0x09;
     const char LF = 0x0A;
+    const char CR = 0x0D;
+    const char SPACE = 0x20;
+    const char COMMA = 0x2C;
+    const char PERIOD = 0x2E;
+    const char SLASH = 0x2F;
     const char COLON = 0x3A;
     const char NUM_0 = 0x30;
+    const char NUM_1 = 0x31;
     const char NUM_9 = 0x39;
     const char UPPER_A = 0x41;
+    const char UPPER_D = 0x44;
+    const char UPPER_F = 0x46;
     const char UPPER_G = 0x47;
     const char UPPER_K = 0x4B;
+    const char UPPER_L = 0x4C;
     const char UPPER_M = 0x4D;
+    const char UPPER_S = 0x53;
+    const char UPPER_T = 0x54;
+    const char UPPER_X = 0x58;
     const char UPPER_Z = 0x5A;
     const char LOWER_A = 0x61;
+    const char LOWER_F = 0x66;
     const char LOWER_Z = 0x7A;
 
     bool is_alphanum(char);
+    bool is_blank(char);
+    bool is_digit(char);
+    i8 hex_value(char);
     char normalize(char);
     void normalize(String&);
 }
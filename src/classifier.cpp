@@ -0,0 +1,76 @@
+#include "classifier.hh"
+#include "consts.hh"
+#include "table.hh"
+#include "types.hh"
+
+Classifier::Classifier(u32 lines, u32 offset_width, bool lazy) {
+    this->offset_width = offset_width;
+    this->shadow = Table();
+    this->shadow.allocate(lines, lazy);
+    this->pages = HashMap<u64, Vector<u64>>();
+    this->page_number = 0;
+    this->page = NULL;
+    this->first = false;
+    this->shadow_hit = false;
+    this->compulsory_count = 0;
+    this->capacity_count = 0;
+    this->conflict_count = 0;
+}
+
+void Classifier::touch(u64 addr, bool allocate) {
+    // Mark the line as seen (one bit per line, in pages allocated on first
+    // touch and looked up by page number unless the page is the last one)
+    // and replay the access on the shadow cache before the real one
+    u64 line = addr >> this->offset_width;
+    if (this->page == NULL || line / consts::SEEN_PAGE != this->page_number) {
+        this->page_number = line / consts::SEEN_PAGE;
+        this->page = &this->pages[this->page_number];
+        if (this->page->empty()) {
+            this->page->assign(consts::SEEN_PAGE / 64, 0);
+        }
+    }
+    auto &word = (*this->page)[line % consts::SEEN_PAGE / 64];
+    auto bit = 1ULL << (line % 64);
+    this->first = (word & bit) == 0;
+    word |= bit;
+
+    auto slot = this->shadow.find(line);
+    this->shadow_hit = slot != consts::NO_SLOT;
+    if (this->shadow_hit) {
+        this->shadow.promote(slot);
+    } else if (allocate) {
+        this->shadow.insert(line);
+    }
+}
+
+void Classifier::classify(u32 misses) {
+    // Classify the real outcome of the access touched last
+    if (misses == 0) {
+        return;
+    } else if (this->first) {
+        this->compulsory_count += misses;
+    } else if (!this->shadow_hit) {
+        this->capacity_count += misses;
+    } else {
+        this->conflict_count += misses;
+    }
+}
+
+u64 Classifier::get_compulsory_count() {
+    return this->compulsory_count;
+}
+
+u64 Classifier::get_capacity_count() {
+    return this->capacity_count;
+}
+
+u64 Classifier::get_conflict_count() {
+    return this->conflict_count;
+}
+
+void Classifier::reset() {
+    // Keep the shadow and the seen lines
+    this->compulsory_count = 0;
+    this->capacity_count = 0;
+    this->conflict_count = 0;
+}
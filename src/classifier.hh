@@ -0,0 +1,29 @@
+#pragma once
+#include "table.hh"
+#include "types.hh"
+
+// Splits the misses of a level into compulsory (first reference to the line),
+// capacity (a fully associative LRU cache of the same size misses too) and
+// conflict (everything else)
+class Classifier {
+    private:
+        u32 offset_width;
+        Table shadow;
+        HashMap<u64, Vector<u64>> pages;
+        u64 page_number;
+        Vector<u64> *page;
+        bool first;
+        bool shadow_hit;
+        u64 compulsory_count;
+        u64 capacity_count;
+        u64 conflict_count;
+
+    public:
+        Classifier(u32, u32, bool);
+        void reset();
+        void touch(u64, bool);
+        void classify(u32);
+        u64 get_compulsory_count();
+        u64 get_capacity_count();
+        u64 get_conflict_count();
+};
@@ -0,0 +1,209 @@
+#include "chars.hh"
+#include "config.hh"
+#include "exceptions.hh"
+#include "text.hh"
+#include "types.hh"
+#include "unit.hh"
+using namespace std;
+
+Config::Config() {
+    this->path = String();
+    this->settings = Vector<Setting>();
+    this->labels = Vector<String>();
+}
+
+void Config::parse(String &path) {
+    // Load the configuration
+    this->path = path;
+    auto file = FileReader(path);
+    if (!file) {
+        auto sb = StringBuilder();
+        sb << "'" << path << "' could not be opened";
+        throw IoException(sb.str());
+    }
+    this->load(file);
+    file.close();
+}
+
+void Config::parse_text(const String &conf) {
+    // Load a configuration held in memory (errors name it as 'conf')
+    this->path = text::CONF;
+    auto stream = StringReader(conf);
+    this->load(stream);
+}
+
+void Config::load(InputStream &file) {
+    String key, value;
+    auto buffer = String();
+    auto unit = Unit();
+    u32 level = 0;
+    this->labels = Vector<String>(1);
+    while (!file.eof()) {
+        auto c = chars::normalize(file.get());
+        if (c == chars::LF || file.eof()) {
+            if (key.length() > 0) {
+                // The end of a key-value pair has been reached
+                value = buffer;
+                buffer.clear();
+                this->add(level, key, value);
+                // Validate every value against the unit
+                for (auto value: this->settings.back().values) {
+                    try {
+                        unit.set(key, value);
+                    } catch (FormatException &e) {
+                        auto sb = StringBuilder();
+                        sb << e.what() << " in '" << this->path << "'";
+                        throw FormatException(sb.str());
+                    }
+                }
+                key.clear();
+                value.clear();
+            }
+        } else if (c == chars::COLON) {
+            // The end of a key has been reached
+            if (buffer.compare(text::LEVEL) == 0 && unit.is_valid()) {
+                level += 1;
+                unit = Unit();
+                this->labels.push_back(String());
+            }
+            key = buffer;
+            buffer.clear();
+        } else if (chars::is_alphanum(c) || c == chars::PERIOD || c == chars::COMMA || c == chars::SLASH) {
+            // Push alphanumeric characters, list/range separators and
+            // sampling rates only
+            buffer.push_back(c);
+        }
+    }
+}
+
+void Config::add(u32 level, String &key, String &value) {
+    auto setting = Setting();
+    setting.level = level;
+    setting.key = key;
+    try {
+        setting.values = this->expand(value);
+    } catch (FormatException &e) {
+        auto sb = StringBuilder();
+        sb << e.what() << " in '" << this->path << "'";
+        throw FormatException(sb.str());
+    }
+    if (key.compare(text::LEVEL) == 0) {
+        // Levels shape the hierarchy so they can't be swept
+        if (setting.values.size() > 1) {
+            auto sb = StringBuilder();
+            sb << "'level' cannot be swept in '" << this->path << "'";
+            throw FormatException(sb.str());
+        }
+        this->labels[level] = value;
+    }
+    this->settings.push_back(setting);
+}
+
+Vector<String> Config::expand(String &value) {
+    // Values are comma separated lists of single values or ranges of the form
+    // 'lower..upper' or 'lower..upperXstep' (the step multiplies, default 2)
+    auto values = Vector<String>();
+    auto items = Vector<String>(1);
+    for (auto c: value) {
+        if (c == chars::COMMA) {
+            items.push_back(String());
+        } else {
+            items.back().push_back(c);
+        }
+    }
+    for (auto &item: items) {
+        auto dots = item.find(text::RANGE);
+        if (dots == String::npos) {
+            values.push_back(item);
+            continue;
+        }
+        auto lower = item.substr(0, dots);
+        auto upper = item.substr(dots + text::RANGE.length());
+        u64 step = 2;
+        auto x = upper.find(chars::UPPER_X);
+        if (x != String::npos) {
+            auto factor = upper.substr(x + 1);
+            step = this->parse_number(factor);
+            upper = upper.substr(0, x);
+        }
+        auto low = this->parse_number(lower);
+        auto high = this->parse_number(upper);
+        if (step < 2 || low == 0 || low > high) {
+            throw FormatException("range could not be parsed");
+        }
+        for (auto v = low; v <= high; v *= step) {
+            values.push_back(to_string(v));
+        }
+    }
+    return values;
+}
+
+u64 Config::parse_number(String &value) {
+    // Parses a whole number with an optional 'K', 'M' or 'G' suffix
+    u64 number = 0;
+    u64 i = 0;
+    for (; i < value.length() && chars::is_digit(value[i]); i++) {
+        number = number * 10 + (value[i] - chars::NUM_0);
+    }
+    if (i == 0 || i + 1 < value.length()) {
+        throw FormatException("range could not be parsed");
+    }
+    if (i < value.length()) {
+        if (value[i] == chars::UPPER_K) {
+            number *= 1024;
+        } else if (value[i] == chars::UPPER_M) {
+            number *= 1024 * 1024;
+        } else if (value[i] == chars::UPPER_G) {
+            number *= 1024 * 1024 * 1024;
+        } else {
+            throw FormatException("range could not be parsed");
+        }
+    }
+    return number;
+}
+
+u64 Config::size() {
+    u64 size = 1;
+    for (auto &setting: this->settings) {
+        size *= setting.values.size();
+    }
+    return size;
+}
+
+Vector<Unit*> Config::build(u64 index) {
+    // The index selects one value per setting (mixed radix, first setting
+    // varies fastest)
+    auto units = Vector<Unit*>();
+    for (u64 i = 0; i < this->labels.size(); i++) {
+        units.push_back(new Unit());
+    }
+    for (auto &setting: this->settings) {
+        auto radix = setting.values.size();
+        auto value = setting.values[index % radix];
+        index /= radix;
+        units[setting.level]->set(setting.key, value);
+    }
+    return units;
+}
+
+Vector<String> Config::header() {
+    auto header = Vector<String>();
+    for (auto &setting: this->settings) {
+        if (setting.values.size() > 1) {
+            header.push_back(this->labels[setting.level] + "." + setting.key);
+        }
+    }
+    return header;
+}
+
+Vector<String> Config::describe(u64 index) {
+    auto values = Vector<String>();
+    for (auto &setting: this->settings) {
+        auto radix = setting.values.size();
+        if (radix > 1) {
+            values.push_back(setting.values[index % radix]);
+        }
+        index /= radix;
+    }
+    return values;
+}
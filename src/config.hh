@@ -0,0 +1,30 @@
+#pragma once
+#include "types.hh"
+#include "unit.hh"
+
+// A key and every value it takes across the sweep (plain data)
+struct Setting {
+    u32 level;
+    String key;
+    Vector<String> values;
+};
+
+class Config {
+    private:
+        String path;
+        Vector<Setting> settings;
+        Vector<String> labels;
+        void load(InputStream&);
+        void add(u32, String&, String&);
+        Vector<String> expand(String&);
+        u64 parse_number(String&);
+
+    public:
+        Config();
+        void parse(String&);
+        void parse_text(const String&);
+        u64 size();
+        Vector<Unit*> build(u64);
+        Vector<String> header();
+        Vector<String> describe(u64);
+};
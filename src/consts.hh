@@ -9,8 +9,117 @@ namespace consts {
     const u8 WRITE_ALLOCATE_ON = 0x01;
     const u8 WRITE_ALLOCATE_OFF = 0x02;
 
+    // Cache organisations
+    const u8 MAIN_MEMORY = 0x01;
+    const u8 DIRECT_MAPPED = 0x02;
+    const u8 SET_ASSOCIATIVE = 0x03;
+    const u8 FULLY_ASSOCIATIVE = 0x04;
+
+    // Replacement policies
+    const u8 LRU = 0x01;
+    const u8 TREE_PLRU = 0x02;
+    const u8 SRRIP = 0x03;
+    const u8 FIFO = 0x04;
+    const u8 RANDOM = 0x05;
+
+    // Coherence protocols and directory states
+    const u8 MSI = 0x01;
+    const u8 MESI = 0x02;
+    const u8 SHARED = 0x01;
+    const u8 EXCLUSIVE = 0x02;
+    const u8 MODIFIED = 0x03;
+
+    // Tag match kernels (sets of at least 'MATCH_WAY' ways are compared in
+    // blocks of 'MATCH_WIDTH')
+    const u8 SCALAR = 0x01;
+    const u8 SSE2 = 0x02;
+    const u8 AVX2 = 0x03;
+    const u32 MATCH_WAY = 16;
+    const u32 MATCH_WIDTH = 64;
+
     // Access states
     const u8 HIT = 0x01;
     const u8 MISS = 0x02;
     const u8 DIRTY = 0x03;
+
+    // Line states (the low bits of a line, below the tag)
+    const u8 LINE_VALID = 0x01;
+    const u8 LINE_DIRTY = 0x02;
+    const u32 LINE_BITS = 2;
+
+    // Replacement state packing (LRU permutations fit 16 ways per word)
+    const u32 PACKED_WAYS = 16;
+    const u64 IDENTITY = 0xFEDCBA9876543210ULL;
+    const u64 NIBBLES = 0x1111111111111111ULL;
+    const u64 PAIRS = 0x5555555555555555ULL;
+    const u64 GOLDEN = 0x9E3779B97F4A7C15ULL;
+
+    // Storage limits (caches at or above 'LAZY_SIZE' are allocated in chunks
+    // of 'CHUNK_LINES' lines on first touch)
+    const u64 LAZY_SIZE = 512ULL * 1024 * 1024;
+    const u64 CHUNK_LINES = 64 * 1024;
+
+    // Fully associative tables (slot sentinel and the initial bucket count of
+    // lazily allocated tables)
+    const u32 NO_SLOT = 0xFFFFFFFF;
+    const u32 TABLE_BUCKETS = 1024;
+
+    // Access file ingestion (records per batch, bytes per streamed read and
+    // batches in flight between the reader and the simulator)
+    const u64 BATCH_SIZE = 4096;
+    const u64 BLOCK_SIZE = 1024 * 1024;
+    const u64 RING_SLOTS = 16;
+    const u64 CACHE_LINE = 64;
+
+    // Compressed access files (formats detected by their magic numbers and
+    // decompressed blocks in flight between the inflater and the reader)
+    const u8 PLAIN = 0x00;
+    const u8 GZIP = 0x01;
+    const u8 ZSTD = 0x02;
+    const u64 INFLATE_SLOTS = 8;
+
+    // Partitioned simulation (records per sharded batch and shards per thread
+    // so uneven shards still balance)
+    const u64 SHARD_BATCH = 1024 * 1024;
+    const u32 SHARDS_PER_THREAD = 4;
+
+    // Multi-core simulation (cores per hierarchy, which a directory entry
+    // tracks in one word, and accesses per epoch)
+    const u32 MAX_CORES = 64;
+    const u64 EPOCH_SIZE = 64 * 1024;
+
+    // Set sampling (z score of the reported confidence interval)
+    const f64 CONFIDENCE = 1.96;
+
+    // Miss classification (lines per page of the first touch bitmap)
+    const u64 SEEN_PAGE = 64 * 1024;
+
+    // Stack distance analysis (initial Fenwick tree size in access times)
+    const u64 CURVE_TIMES = 1024 * 1024;
+
+    // Event logging (events buffered per thread between writes)
+    const u64 EVENT_BUFFER = 64 * 1024;
+
+    // Synthetic access patterns
+    const u8 GEN_RANDOM = 0x01;
+    const u8 GEN_GROUPS = 0x02;
+    const u8 GEN_STREAM = 0x03;
+    const u8 GEN_STRIDE = 0x04;
+    const u8 GEN_ZIPF = 0x05;
+    const u8 GEN_CHASE = 0x06;
+
+    // Synthetic pattern defaults (the groups match 'test/groups', the hot
+    // lines are scattered by a prime multiplier and stores are a percentage)
+    const u64 GEN_GROUP_SIZE = 32;
+    const u64 GEN_GROUP_SPREAD = 256;
+    const u64 GEN_WORD = 8;
+    const u64 GEN_STRIDE_BYTES = 4096;
+    const u64 GEN_REGION = 64 * 1024 * 1024;
+    const u64 GEN_LINE = 64;
+    const u64 GEN_HOT_LINES = 1024 * 1024;
+    const u64 GEN_CHASE_LINES = 64 * 1024;
+    const u64 GEN_SCATTER = 2654435761ULL;
+    const f64 GEN_SKEW = 0.99;
+    const u32 GEN_STORE_PERCENT = 30;
+    const u32 GEN_SCRIPT_PERCENT = 50;
 }
@@ -0,0 +1,109 @@
+#include <algorithm>
+#include "consts.hh"
+#include "curve.hh"
+#include "types.hh"
+using namespace std;
+
+Curve::Curve() {
+    this->now = 0;
+    this->cold = 0;
+    this->tree = Vector<u32>(consts::CURVE_TIMES + 1, 0);
+    this->histogram = Vector<u64>();
+    this->last = HashMap<u64, u64>();
+}
+
+void Curve::touch(u64 line) {
+    // Every line is marked at the time it was last touched, so the number of
+    // marks after that time is the number of distinct lines touched since
+    // (its LRU stack distance)
+    auto entry = this->last.find(line);
+    if (entry == this->last.end()) {
+        this->cold += 1;
+        this->last[line] = this->now;
+    } else {
+        auto distance = this->count(this->now) - this->count(entry->second + 1);
+        if (distance >= this->histogram.size()) {
+            this->histogram.resize(distance + 1, 0);
+        }
+        this->histogram[distance] += 1;
+        this->mark(entry->second, -1);
+        entry->second = this->now;
+    }
+    this->mark(this->now, 1);
+    this->now += 1;
+
+    // Renumber the live marks once the times run out
+    if (this->now + 1 >= this->tree.size()) {
+        this->compact();
+    }
+}
+
+u64 Curve::get_access_count() {
+    auto count = this->cold;
+    for (auto hits: this->histogram) {
+        count += hits;
+    }
+    return count;
+}
+
+u64 Curve::get_hit_count(u64 lines) {
+    // A fully associative LRU cache of 'lines' lines hits every reuse with a
+    // stack distance below its capacity
+    u64 count = 0;
+    for (u64 i = 0; i < lines && i < this->histogram.size(); i++) {
+        count += this->histogram[i];
+    }
+    return count;
+}
+
+u64 Curve::get_max_distance() {
+    return this->histogram.size();
+}
+
+void Curve::mark(u64 time, i32 delta) {
+    // Fenwick tree update (1-based)
+    for (auto i = time + 1; i < this->tree.size(); i += i & (0 - i)) {
+        this->tree[i] += delta;
+    }
+}
+
+u64 Curve::count(u64 time) {
+    // Number of marks strictly before 'time'
+    u64 count = 0;
+    for (auto i = time; i > 0; i -= i & (0 - i)) {
+        count += this->tree[i];
+    }
+    return count;
+}
+
+void Curve::compact() {
+    // Order the lines by their last touch and give them consecutive times
+    auto lines = Vector<pair<u64, u64>>();
+    lines.reserve(this->last.size());
+    for (auto &entry: this->last) {
+        lines.push_back(make_pair(entry.second, entry.first));
+    }
+    sort(lines.begin(), lines.end());
+
+    // Keep at least as many free times as live lines so compaction stays
+    // amortized
+    auto size = max((u64)consts::CURVE_TIMES, (u64)lines.size() * 2);
+    this->tree.assign(size + 1, 0);
+    for (u64 i = 0; i < lines.size(); i++) {
+        this->last[lines[i].second] = i;
+        this->tree[i + 1] = 1;
+    }
+    for (u64 i = 1; i < this->tree.size(); i++) {
+        auto parent = i + (i & (0 - i));
+        if (parent < this->tree.size()) {
+            this->tree[parent] += this->tree[i];
+        }
+    }
+    this->now = lines.size();
+}
+
+void Curve::reset() {
+    // Keep the last access times so distances still span the reset
+    this->cold = 0;
+    this->histogram.assign(this->histogram.size(), 0);
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include "types.hh"
+
+class Curve {
+    private:
+        u64 now;
+        u64 cold;
+        Vector<u32> tree;
+        Vector<u64> histogram;
+        HashMap<u64, u64> last;
+        void mark(u64, i32);
+        u64 count(u64);
+        void compact();
+
+    public:
+        Curve();
+        void reset();
+        void touch(u64);
+        u64 get_access_count();
+        u64 get_hit_count(u64);
+        u64 get_max_distance();
+};
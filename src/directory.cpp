@@ -0,0 +1,97 @@
+#include "consts.hh"
+#include "directory.hh"
+#include "types.hh"
+#include "unit.hh"
+
+Directory::Directory(u8 protocol, u32 shift) {
+    this->protocol = protocol;
+    this->shift = shift;
+    this->lines = HashMap<u64, Sharers>();
+    this->invalidation_count = 0;
+    this->intervention_count = 0;
+    this->upgrade_count = 0;
+    this->writeback_count = 0;
+}
+
+void Directory::load(u32 core, u64 line, Vector<Unit*> &cores, Unit *shared) {
+    auto &sharers = this->lines[line];
+    auto bit = 1ULL << core;
+    if (sharers.cores & bit) {
+        // Any state can be read
+        return;
+    }
+    if (sharers.cores != 0 && (sharers.state == consts::MODIFIED || sharers.state == consts::EXCLUSIVE)) {
+        // The owner keeps a shared copy (writing a modified one back)
+        this->intervention_count += 1;
+        this->revoke(__builtin_ctzll(sharers.cores), line, false, cores, shared);
+        sharers.cores |= bit;
+        sharers.state = consts::SHARED;
+    } else if (sharers.cores == 0) {
+        // The only copy is exclusive under MESI
+        sharers.cores = bit;
+        sharers.state = this->protocol == consts::MESI ? consts::EXCLUSIVE : consts::SHARED;
+    } else {
+        sharers.cores |= bit;
+        sharers.state = consts::SHARED;
+    }
+}
+
+void Directory::store(u32 core, u64 line, Vector<Unit*> &cores, Unit *shared) {
+    auto &sharers = this->lines[line];
+    auto bit = 1ULL << core;
+    if (sharers.cores == bit && sharers.state != consts::SHARED) {
+        // Exclusive lines are modified silently
+        sharers.state = consts::MODIFIED;
+        return;
+    }
+    if ((sharers.cores & bit) && sharers.state == consts::SHARED) {
+        this->upgrade_count += 1;
+    }
+
+    // Every other copy is invalidated (writing a modified one back)
+    auto others = sharers.cores & ~bit;
+    while (others != 0) {
+        this->invalidation_count += 1;
+        this->revoke(__builtin_ctzll(others), line, true, cores, shared);
+        others &= others - 1;
+    }
+    sharers.cores = bit;
+    sharers.state = consts::MODIFIED;
+}
+
+void Directory::revoke(u32 core, u64 line, bool invalidate, Vector<Unit*> &cores, Unit *shared) {
+    // Dirty private copies are written to the shared levels
+    auto addr = line << this->shift;
+    if (cores[core]->revoke(addr, 1ULL << this->shift, invalidate)) {
+        this->writeback_count += 1;
+        shared->store(addr);
+    }
+}
+
+void Directory::reset() {
+    // Clear the counters but keep the lines
+    this->invalidation_count = 0;
+    this->intervention_count = 0;
+    this->upgrade_count = 0;
+    this->writeback_count = 0;
+}
+
+u8 Directory::get_protocol() {
+    return this->protocol;
+}
+
+u64 Directory::get_invalidation_count() {
+    return this->invalidation_count;
+}
+
+u64 Directory::get_intervention_count() {
+    return this->intervention_count;
+}
+
+u64 Directory::get_upgrade_count() {
+    return this->upgrade_count;
+}
+
+u64 Directory::get_writeback_count() {
+    return this->writeback_count;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include "types.hh"
+
+class Unit;
+
+// The cores that may hold a line and the line's state
+struct Sharers {
+    u64 cores;
+    u8 state;
+};
+
+// Keeps the private levels of a multi-core hierarchy coherent with MSI or
+// MESI invalidation. Private levels drop clean lines silently, so the sharers
+// are a superset of the cores that still hold a line (like a directory that
+// isn't told about clean evictions).
+class Directory {
+    private:
+        u8 protocol;
+        u32 shift;
+        HashMap<u64, Sharers> lines;
+        u64 invalidation_count;
+        u64 intervention_count;
+        u64 upgrade_count;
+        u64 writeback_count;
+        void revoke(u32, u64, bool, Vector<Unit*>&, Unit*);
+
+    public:
+        Directory(u8, u32);
+        void load(u32, u64, Vector<Unit*>&, Unit*);
+        void store(u32, u64, Vector<Unit*>&, Unit*);
+        void reset();
+        u8 get_protocol();
+        u64 get_invalidation_count();
+        u64 get_intervention_count();
+        u64 get_upgrade_count();
+        u64 get_writeback_count();
+};
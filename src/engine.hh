@@ -0,0 +1,354 @@
+#pragma once
+#include "consts.hh"
+#include "events.hh"
+#include "policy.hh"
+#include "storage.hh"
+#include "table.hh"
+#include "types.hh"
+#include "unit.hh"
+
+// Access routines for one organisation, replacement policy, write hit policy,
+// write miss policy and line size. Every policy decision is made at compile
+// time; an offset width of zero reads the width from the unit instead. Each
+// access looks its level up once: a miss picks the victim, fills the line and
+// (for write allocation) applies the write in place, and the level below sees
+// the victim's write back, the fill and any write through, in that order. Lines
+// only keep their tag, so the victim's address is rebuilt from the tag and the
+// set index (the first byte of the line). A level remembers the line of its
+// last hit (or allocating write), and repeats of that line hit without a
+// lookup: touching the most recent line again leaves every replacement state
+// as it is.
+// Every routine returns the cumulative access time. Builds with
+// 'CACHESIM_EVENTS' also record each lookup and write back in the event log.
+template <u8 Organisation, typename Policy, u8 WriteHit, u8 WriteMiss, u32 OffsetWidth>
+class Engine {
+    private:
+        template <bool Store> static bool repeat(Unit&, u64);
+        template <bool Store> static u8 access(Unit&, u64, u64&);
+        template <bool Store> static u8 access_mmap(Unit&, u64, u64&);
+        template <bool Store> static u8 access_dmap(Unit&, u64, u32, u32, u64&);
+        template <bool Store> static u8 access_nmap(Unit&, u64, u32, u32, u64&);
+
+    public:
+        static u32 read(Unit&, u64);
+        static u32 write(Unit&, u64);
+};
+
+namespace engine {
+    // Binds the engine matching the unit's line size
+    template <u8 Organisation, typename Policy, u8 WriteHit, u8 WriteMiss>
+    void bind(u32 offset_width, Handler &reader, Handler &writer) {
+        switch (offset_width) {
+            case 5:
+                reader = &Engine<Organisation, Policy, WriteHit, WriteMiss, 5>::read;
+                writer = &Engine<Organisation, Policy, WriteHit, WriteMiss, 5>::write;
+                break;
+            case 6:
+                reader = &Engine<Organisation, Policy, WriteHit, WriteMiss, 6>::read;
+                writer = &Engine<Organisation, Policy, WriteHit, WriteMiss, 6>::write;
+                break;
+            case 7:
+                reader = &Engine<Organisation, Policy, WriteHit, WriteMiss, 7>::read;
+                writer = &Engine<Organisation, Policy, WriteHit, WriteMiss, 7>::write;
+                break;
+            case 8:
+                reader = &Engine<Organisation, Policy, WriteHit, WriteMiss, 8>::read;
+                writer = &Engine<Organisation, Policy, WriteHit, WriteMiss, 8>::write;
+                break;
+            default:
+                reader = &Engine<Organisation, Policy, WriteHit, WriteMiss, 0>::read;
+                writer = &Engine<Organisation, Policy, WriteHit, WriteMiss, 0>::write;
+                break;
+        }
+    }
+
+    // Binds the engine matching the unit's write policies
+    template <u8 Organisation, typename Policy>
+    void bind(u8 write_hit_policy, u8 write_miss_policy, u32 offset_width, Handler &reader, Handler &writer) {
+        if (write_hit_policy == consts::WRITE_BACK) {
+            if (write_miss_policy == consts::WRITE_ALLOCATE_ON) {
+                bind<Organisation, Policy, consts::WRITE_BACK, consts::WRITE_ALLOCATE_ON>(offset_width, reader, writer);
+            } else {
+                bind<Organisation, Policy, consts::WRITE_BACK, consts::WRITE_ALLOCATE_OFF>(offset_width, reader, writer);
+            }
+        } else {
+            if (write_miss_policy == consts::WRITE_ALLOCATE_ON) {
+                bind<Organisation, Policy, consts::WRITE_THROUGH, consts::WRITE_ALLOCATE_ON>(offset_width, reader, writer);
+            } else {
+                bind<Organisation, Policy, consts::WRITE_THROUGH, consts::WRITE_ALLOCATE_OFF>(offset_width, reader, writer);
+            }
+        }
+    }
+
+    // Binds the engine matching the unit's replacement policy
+    template <u8 Organisation>
+    void bind(u8 replacement, u32 way, u8 write_hit_policy, u8 write_miss_policy, u32 offset_width, Handler &reader, Handler &writer) {
+        if (replacement == consts::TREE_PLRU) {
+            bind<Organisation, TreePlru>(write_hit_policy, write_miss_policy, offset_width, reader, writer);
+        } else if (replacement == consts::SRRIP) {
+            bind<Organisation, Srrip>(write_hit_policy, write_miss_policy, offset_width, reader, writer);
+        } else if (replacement == consts::FIFO) {
+            bind<Organisation, Fifo>(write_hit_policy, write_miss_policy, offset_width, reader, writer);
+        } else if (replacement == consts::RANDOM) {
+            bind<Organisation, Random>(write_hit_policy, write_miss_policy, offset_width, reader, writer);
+        } else if (way <= consts::PACKED_WAYS) {
+            bind<Organisation, PackedLru>(write_hit_policy, write_miss_policy, offset_width, reader, writer);
+        } else {
+            bind<Organisation, RankedLru>(write_hit_policy, write_miss_policy, offset_width, reader, writer);
+        }
+    }
+}
+
+template <u8 Organisation, typename Policy, u8 WriteHit, u8 WriteMiss, u32 OffsetWidth>
+u32 Engine<Organisation, Policy, WriteHit, WriteMiss, OffsetWidth>::read(Unit &unit, u64 addr) {
+    u64 victim = 0;
+    u32 time = unit.hit_time;
+    auto status = repeat<false>(unit, addr) ? consts::HIT : access<false>(unit, addr, victim);
+#ifdef CACHESIM_EVENTS
+    events::record(unit.level, addr, status == consts::HIT ? events::READ_HIT : events::READ_MISS);
+    if (status == consts::DIRTY) {
+        events::record(unit.level, victim, events::WRITEBACK);
+    }
+#endif
+    if (status == consts::HIT) {
+        // Load hit stops immediately
+        unit.hit_count += 1;
+    } else {
+        // Load miss writes the dirty victim back (if any) and descends to the
+        // next level
+        unit.miss_count += 1;
+        if (status == consts::DIRTY) {
+            time += unit.next->store(victim);
+        }
+        time += unit.next->load(addr);
+    }
+    unit.access_time += time;
+    return time;
+}
+
+template <u8 Organisation, typename Policy, u8 WriteHit, u8 WriteMiss, u32 OffsetWidth>
+u32 Engine<Organisation, Policy, WriteHit, WriteMiss, OffsetWidth>::write(Unit &unit, u64 addr) {
+    u64 victim = 0;
+    u32 time = unit.hit_time;
+    auto status = repeat<true>(unit, addr) ? consts::HIT : access<true>(unit, addr, victim);
+#ifdef CACHESIM_EVENTS
+    events::record(unit.level, addr, status == consts::HIT ? events::WRITE_HIT : events::WRITE_MISS);
+    if (status == consts::DIRTY) {
+        events::record(unit.level, victim, events::WRITEBACK);
+    }
+#endif
+    if (status == consts::HIT) {
+        // Write hit behavior depends on the policy
+        unit.hit_count += 1;
+        if (WriteHit == consts::WRITE_THROUGH) {
+            // Write through descends to the next level
+            time += unit.next->store(addr);
+        }
+        // Write back stops immediately
+    } else {
+        // Write miss behavior depends on the policy
+        unit.miss_count += 1;
+        if (WriteMiss == consts::WRITE_ALLOCATE_ON) {
+            // Write allocation loads the block like a read miss (the write
+            // itself was applied to the filled line)
+            if (status == consts::DIRTY) {
+                time += unit.next->store(victim);
+            }
+            time += unit.next->load(addr);
+            if (WriteHit == consts::WRITE_THROUGH) {
+                time += unit.next->store(addr);
+            }
+        } else {
+            // No write allocation descends to the next level
+            time += unit.next->store(addr);
+        }
+    }
+    unit.access_time += time;
+    return time;
+}
+
+template <u8 Organisation, typename Policy, u8 WriteHit, u8 WriteMiss, u32 OffsetWidth>
+template <bool Store>
+bool Engine<Organisation, Policy, WriteHit, WriteMiss, OffsetWidth>::repeat(Unit &unit, u64 addr) {
+    // Hits the recent line in place (the caller counts it like any hit)
+    auto offset_width = OffsetWidth > 0 ? OffsetWidth : unit.offset_width;
+    if (Organisation == consts::MAIN_MEMORY || !unit.recent || addr >> offset_width != unit.recent_block) {
+        return false;
+    }
+    if (Store && WriteHit == consts::WRITE_BACK) {
+        if (Organisation == consts::FULLY_ASSOCIATIVE) {
+            unit.table.set_dirty(unit.recent_slot, true);
+        } else {
+            *unit.recent_line |= consts::LINE_DIRTY;
+        }
+    }
+    return true;
+}
+
+template <u8 Organisation, typename Policy, u8 WriteHit, u8 WriteMiss, u32 OffsetWidth>
+template <bool Store>
+u8 Engine<Organisation, Policy, WriteHit, WriteMiss, OffsetWidth>::access(Unit &unit, u64 addr, u64 &victim) {
+    // Main memory always hits
+    if (Organisation == consts::MAIN_MEMORY) {
+        return consts::HIT;
+    }
+
+    // Break apart address (the shifts and masks are computed on finalize)
+    auto offset_width = OffsetWidth > 0 ? OffsetWidth : unit.offset_width;
+    u64 tag = addr >> unit.tag_shift;
+    u32 set = (u32)(addr >> offset_width) & unit.set_mask;
+    unit.recent_block = addr >> offset_width;
+
+    // Access the appropriate cache
+    if (Organisation == consts::DIRECT_MAPPED) {
+        return access_dmap<Store>(unit, tag, set, offset_width, victim);
+    } else if (Organisation == consts::FULLY_ASSOCIATIVE) {
+        return access_mmap<Store>(unit, tag, victim);
+    }
+    return access_nmap<Store>(unit, tag, set, offset_width, victim);
+}
+
+template <u8 Organisation, typename Policy, u8 WriteHit, u8 WriteMiss, u32 OffsetWidth>
+template <bool Store>
+u8 Engine<Organisation, Policy, WriteHit, WriteMiss, OffsetWidth>::access_mmap(Unit &unit, u64 tag, u64 &victim) {
+    // Fully associative cache algorithm (LRU)
+    auto &table = unit.table;
+    auto slot = table.find(tag);
+    if (slot != consts::NO_SLOT) {
+        // The tag was found (hit)
+        if (Store && WriteHit == consts::WRITE_BACK) {
+            // Write only: set the dirty bit on write hit + write back
+            table.set_dirty(slot, true);
+        }
+        // Read + write: move the block to the front
+        table.promote(slot);
+        unit.recent = true;
+        unit.recent_slot = slot;
+        return consts::HIT;
+    }
+
+    // The tag could not be found (miss)
+    if (Store && WriteMiss == consts::WRITE_ALLOCATE_OFF) {
+        unit.recent = false;
+        return consts::MISS;
+    }
+    auto status = consts::MISS;
+    if (table.is_full()) {
+        unit.eviction_count += 1;
+        if (table.get_dirty(table.get_last())) {
+            // The last block is dirty so the controller must write it to
+            // the next memory unit
+            victim = table.get_tag(table.get_last()) << unit.tag_shift;
+            status = consts::DIRTY;
+            unit.writeback_count += 1;
+        }
+    }
+    // Replace the last block (if full) with the new block at the front
+    slot = table.insert(tag);
+    if (Store && WriteHit == consts::WRITE_BACK) {
+        // Write allocation: set the dirty bit on the filled block
+        table.set_dirty(slot, true);
+    }
+    unit.recent = true;
+    unit.recent_slot = slot;
+    return status;
+}
+
+template <u8 Organisation, typename Policy, u8 WriteHit, u8 WriteMiss, u32 OffsetWidth>
+template <bool Store>
+u8 Engine<Organisation, Policy, WriteHit, WriteMiss, OffsetWidth>::access_dmap(Unit &unit, u64 tag, u32 set, u32 offset_width, u64 &victim) {
+    // Direct mapped cache algorithm
+    auto lines = unit.storage.get(set);
+    if (lines.find(tag) == 0) {
+        // The block is valid and the tags match (hit)
+        if (Store && WriteHit == consts::WRITE_BACK) {
+            // Write only: set the dirty bit on write hit + write back
+            lines.set_dirty(0, true);
+        }
+        unit.recent = true;
+        unit.recent_line = lines.get_line(0);
+        return consts::HIT;
+    }
+
+    // The block is invalid or the tags do not match (miss + eviction)
+    if (Store && WriteMiss == consts::WRITE_ALLOCATE_OFF) {
+        unit.recent = false;
+        return consts::MISS;
+    }
+    auto status = consts::MISS;
+    if (lines.get_valid(0)) {
+        unit.eviction_count += 1;
+        if (lines.get_dirty(0)) {
+            // The block is dirty so the controller must write it to the
+            // next memory unit
+            victim = lines.get_tag(0) << unit.tag_shift | (u64)set << offset_width;
+            status = consts::DIRTY;
+            unit.writeback_count += 1;
+        }
+    }
+    // 'Load' the block
+    lines.fill(0, tag);
+    if (Store && WriteHit == consts::WRITE_BACK) {
+        // Write allocation: set the dirty bit on the filled block
+        lines.set_dirty(0, true);
+    }
+    unit.recent = true;
+    unit.recent_line = lines.get_line(0);
+    return status;
+}
+
+template <u8 Organisation, typename Policy, u8 WriteHit, u8 WriteMiss, u32 OffsetWidth>
+template <bool Store>
+u8 Engine<Organisation, Policy, WriteHit, WriteMiss, OffsetWidth>::access_nmap(Unit &unit, u64 tag, u32 set, u32 offset_width, u64 &victim) {
+    // Set associative cache algorithm
+    auto lines = unit.storage.get(set);
+    auto index = lines.find(tag);
+    if (index != unit.way) {
+        // The tag was found (hit)
+        if (Store && WriteHit == consts::WRITE_BACK) {
+            // Write only: set the dirty bit on write hit + write back
+            lines.set_dirty(index, true);
+        }
+        // Read + write: update the replacement state
+        Policy::touch(lines, index);
+        unit.recent = true;
+        unit.recent_line = lines.get_line(index);
+        return consts::HIT;
+    }
+
+    // The tag could not be found (miss)
+    if (Store && WriteMiss == consts::WRITE_ALLOCATE_OFF) {
+        unit.recent = false;
+        return consts::MISS;
+    }
+    // The victim is a free line if there is one, otherwise the replacement
+    // policy chooses
+    auto status = consts::MISS;
+    index = lines.free();
+    if (index == unit.way) {
+        index = Policy::victim(lines);
+        unit.eviction_count += 1;
+        if (lines.get_dirty(index)) {
+            // The block is dirty so the controller must write it to the next
+            // memory unit
+            victim = lines.get_tag(index) << unit.tag_shift | (u64)set << offset_width;
+            status = consts::DIRTY;
+            unit.writeback_count += 1;
+        }
+    }
+    // Replace the victim with the new block
+    lines.fill(index, tag);
+    Policy::insert(lines, index);
+    if (Store) {
+        // Write allocation: the write hits the filled block
+        if (WriteHit == consts::WRITE_BACK) {
+            lines.set_dirty(index, true);
+        }
+        Policy::touch(lines, index);
+    }
+    // Only a touched line can be touched again for free (some policies
+    // insert lines further from the front than a hit moves them)
+    unit.recent = Store;
+    unit.recent_line = lines.get_line(index);
+    return status;
+}
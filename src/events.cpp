@@ -0,0 +1,105 @@
+#include "consts.hh"
+#include "events.hh"
+#include "exceptions.hh"
+#include "types.hh"
+using namespace std;
+
+namespace events {
+    bool enabled = false;
+    thread_local Buffer buffer;
+
+    // The shared log the buffers are written to
+    String path;
+    FileWriter file;
+    bool binary = false;
+    Mutex lock;
+
+    Buffer::Buffer() {
+        this->events = Vector<Event>();
+        this->events.reserve(consts::EVENT_BUFFER);
+    }
+
+    Buffer::~Buffer() {
+        this->flush();
+    }
+
+    void Buffer::flush() {
+        if (!this->events.empty()) {
+            write(this->events.data(), this->events.size());
+            this->events.clear();
+        }
+    }
+
+    void open(const String &output, bool binary_format) {
+        path = output;
+        binary = binary_format;
+        file = FileWriter(output, FileWriter::binary | FileWriter::trunc);
+        if (!file) {
+            auto sb = StringBuilder();
+            sb << "'" << output << "' could not be opened";
+            throw IoException(sb.str());
+        }
+        if (binary) {
+            u8 version[sizeof(VERSION)];
+            for (u32 i = 0; i < sizeof(VERSION); i++) {
+                version[i] = (u8)(VERSION >> (8 * i));
+            }
+            file.write((const char*)MAGIC, sizeof(MAGIC));
+            file.write((const char*)version, sizeof(version));
+        }
+        enabled = true;
+    }
+
+    void write(const Event *events, u64 count) {
+        // Format the whole block before taking the lock
+        auto block = String();
+        if (binary) {
+            block.resize(count * RECORD_SIZE);
+            auto *bytes = (u8*)&block[0];
+            for (u64 i = 0; i < count; i++, bytes += RECORD_SIZE) {
+                for (u32 j = 0; j < sizeof(u64); j++) {
+                    bytes[j] = (u8)(events[i].address >> (8 * j));
+                }
+                bytes[8] = events[i].level;
+                bytes[9] = events[i].kind;
+            }
+        } else {
+            for (u64 i = 0; i < count; i++) {
+                auto &event = events[i];
+                block += "[";
+                block += event.level == consts::MAIN ? "Main" : "L" + to_string(event.level);
+                switch (event.kind) {
+                    case READ_HIT:
+                        block += "] read " + to_string(event.address) + " : HIT\n";
+                        break;
+                    case READ_MISS:
+                        block += "] read " + to_string(event.address) + " : MISS\n";
+                        break;
+                    case WRITE_HIT:
+                        block += "] write " + to_string(event.address) + " : HIT\n";
+                        break;
+                    case WRITE_MISS:
+                        block += "] write " + to_string(event.address) + " : MISS\n";
+                        break;
+                    default:
+                        block += "] writeback " + to_string(event.address) + "\n";
+                        break;
+                }
+            }
+        }
+        std::lock_guard<Mutex> guard(lock);
+        file.write(block.data(), block.size());
+    }
+
+    void close() {
+        // Write what is left on this thread (the others flushed on exit)
+        buffer.flush();
+        enabled = false;
+        file.close();
+        if (!file) {
+            auto sb = StringBuilder();
+            sb << "'" << path << "' could not be written";
+            throw IoException(sb.str());
+        }
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "types.hh"
+
+// Per access event log (only compiled in with 'CACHESIM_EVENTS'). Every level
+// access is recorded with its result, as is every write back of a dirty
+// victim, into a buffer per thread that is written out in large blocks.
+// Text logs use the '[L1] read 1024 : MISS' lines of 'test/*/out'. Binary
+// logs start with the magic and version and hold one 10 byte record per event:
+// the 64-bit little-endian address, the level (0xFF is main memory) and the
+// kind.
+namespace events {
+    const u8 MAGIC[] = {'C', 'S', 'I', 'M', 'E', 'V', 'T', 0x00};
+    const u32 VERSION = 2;
+    const u64 RECORD_SIZE = 10;
+
+    // Event kinds
+    const u8 READ_HIT = 0x01;
+    const u8 READ_MISS = 0x02;
+    const u8 WRITE_HIT = 0x03;
+    const u8 WRITE_MISS = 0x04;
+    const u8 WRITEBACK = 0x05;
+
+    // One event (plain data so buffers are formatted in bulk)
+    struct Event {
+        u64 address;
+        u8 level;
+        u8 kind;
+    };
+
+    // The events of one thread, written out when full or when the thread
+    // exits
+    class Buffer {
+        public:
+            Vector<Event> events;
+            Buffer();
+            ~Buffer();
+            void flush();
+    };
+
+    extern bool enabled;
+    extern thread_local Buffer buffer;
+    void open(const String&, bool);
+    void write(const Event*, u64);
+    void close();
+
+    inline void record(u8 level, u64 address, u8 kind) {
+        if (enabled) {
+            buffer.events.push_back(Event{address, level, kind});
+            if (buffer.events.size() == buffer.events.capacity()) {
+                buffer.flush();
+            }
+        }
+    }
+}
@@ -0,0 +1,181 @@
+#include <algorithm>
+#include <cmath>
+#include "consts.hh"
+#include "exceptions.hh"
+#include "generator.hh"
+#include "record.hh"
+#include "text.hh"
+#include "types.hh"
+using namespace std;
+
+Generator::Generator(const String &pattern, u64 count, u64 seed) {
+    this->pattern = 0;
+    this->count = count;
+    this->index = 0;
+    this->parameter = 0;
+    this->state = seed;
+    this->center = 0;
+    this->current = 0;
+    this->chain = Vector<u32>();
+    this->zeta = 0;
+    this->alpha = 0;
+    this->eta = 0;
+
+    // Split the optional parameter from the name
+    auto colon = pattern.find(':');
+    auto name = pattern.substr(0, colon);
+    if (name.compare(text::GEN_RANDOM) == 0) {
+        this->pattern = consts::GEN_RANDOM;
+    } else if (name.compare(text::GEN_GROUPS) == 0) {
+        this->pattern = consts::GEN_GROUPS;
+        this->parameter = consts::GEN_GROUP_SIZE;
+    } else if (name.compare(text::GEN_STREAM) == 0) {
+        this->pattern = consts::GEN_STREAM;
+        this->parameter = consts::GEN_WORD;
+    } else if (name.compare(text::GEN_STRIDE) == 0) {
+        this->pattern = consts::GEN_STRIDE;
+        this->parameter = consts::GEN_STRIDE_BYTES;
+    } else if (name.compare(text::GEN_ZIPF) == 0) {
+        this->pattern = consts::GEN_ZIPF;
+        this->parameter = consts::GEN_HOT_LINES;
+    } else if (name.compare(text::GEN_CHASE) == 0) {
+        this->pattern = consts::GEN_CHASE;
+        this->parameter = consts::GEN_CHASE_LINES;
+    } else {
+        auto sb = StringBuilder();
+        sb << "unrecognized pattern '" << name << "'";
+        throw FormatException(sb.str());
+    }
+    if (colon != String::npos) {
+        u64 parameter = 0;
+        try {
+            parameter = stoull(pattern.substr(colon + 1));
+        } catch (Exception &e) {
+        }
+
+        // Lines must stay within the 32-bit address space
+        auto limit = (1ULL << 32) / (
+            this->pattern == consts::GEN_ZIPF || this->pattern == consts::GEN_CHASE ? consts::GEN_LINE : 1
+        );
+        if (this->pattern == consts::GEN_RANDOM || parameter == 0 || parameter >= limit) {
+            auto sb = StringBuilder();
+            sb << "'" << pattern << "' has an invalid parameter";
+            throw FormatException(sb.str());
+        }
+        this->parameter = parameter;
+    }
+    if (this->pattern == consts::GEN_ZIPF) {
+        this->prepare_zipf();
+    } else if (this->pattern == consts::GEN_CHASE) {
+        this->prepare_chase();
+    }
+}
+
+void Generator::prepare_zipf() {
+    // Constants of the rejection free zipfian sampler from "Quickly
+    // Generating Billion-Record Synthetic Databases" (Gray et al.)
+    auto n = (f64)this->parameter;
+    auto theta = consts::GEN_SKEW;
+    this->zeta = 0;
+    for (u64 i = 1; i <= this->parameter; i++) {
+        this->zeta += 1.0 / pow((f64)i, theta);
+    }
+    auto zeta2 = 1.0 + pow(0.5, theta);
+    this->alpha = 1.0 / (1.0 - theta);
+    this->eta = (1.0 - pow(2.0 / n, 1.0 - theta)) / (1.0 - zeta2 / this->zeta);
+}
+
+void Generator::prepare_chase() {
+    // A single random cycle through every line (Sattolo's algorithm), so the
+    // chase visits the whole working set before it repeats
+    this->chain.resize(this->parameter);
+    for (u64 i = 0; i < this->parameter; i++) {
+        this->chain[i] = (u32)i;
+    }
+    for (u64 i = this->parameter - 1; i > 0; i--) {
+        swap(this->chain[i], this->chain[this->next() % i]);
+    }
+}
+
+u64 Generator::next() {
+    // SplitMix64
+    auto x = (this->state += consts::GOLDEN);
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+f64 Generator::uniform() {
+    // Uniform in [0, 1) from the top 53 bits
+    return (this->next() >> 11) * (1.0 / (1ULL << 53));
+}
+
+bool Generator::store(u32 percent) {
+    return this->next() % 100 < percent;
+}
+
+u32 Generator::generate(bool &store) {
+    switch (this->pattern) {
+        case consts::GEN_RANDOM: {
+            // Any instruction and any 32-bit address (like 'test/random')
+            store = this->store(consts::GEN_SCRIPT_PERCENT);
+            return (u32)this->next();
+        }
+        case consts::GEN_GROUPS: {
+            // Clusters of addresses around a random center (like 'test/groups')
+            if (this->index % this->parameter == 0) {
+                this->center = (u32)this->next();
+            }
+            auto half = consts::GEN_GROUP_SPREAD / 2;
+            auto lower = this->center > half ? this->center - half : 0;
+            auto upper = min((u64)this->center + half, (u64)UINT32_MAX);
+            store = this->store(consts::GEN_SCRIPT_PERCENT);
+            return (u32)(lower + this->next() % (upper - lower + 1));
+        }
+        case consts::GEN_STREAM: {
+            // Consecutive words through the whole address space
+            store = this->store(consts::GEN_STORE_PERCENT);
+            return (u32)(this->index * this->parameter);
+        }
+        case consts::GEN_STRIDE: {
+            // Fixed strides through a region, wrapping around at its end
+            store = this->store(consts::GEN_STORE_PERCENT);
+            return (u32)((this->index * this->parameter) % consts::GEN_REGION);
+        }
+        case consts::GEN_ZIPF: {
+            // A zipfian rank, scattered over the hot lines by a prime
+            // multiplier so the hottest lines don't share sets
+            auto u = this->uniform();
+            auto uz = u * this->zeta;
+            u64 rank = 0;
+            if (uz >= 1.0 + pow(0.5, consts::GEN_SKEW)) {
+                rank = (u64)(this->parameter * pow(this->eta * u - this->eta + 1.0, this->alpha));
+                rank = min(rank, this->parameter - 1);
+            } else if (uz >= 1.0) {
+                rank = 1;
+            }
+            auto line = rank * consts::GEN_SCATTER % this->parameter;
+            auto word = this->next() % (consts::GEN_LINE / consts::GEN_WORD);
+            store = this->store(consts::GEN_STORE_PERCENT);
+            return (u32)(line * consts::GEN_LINE + word * consts::GEN_WORD);
+        }
+        default: {
+            // Each load depends on the previous one
+            auto line = this->current;
+            this->current = this->chain[line];
+            store = false;
+            return (u32)(line * consts::GEN_LINE);
+        }
+    }
+}
+
+u64 Generator::read(Record *records, u64 count) {
+    u64 n = 0;
+    while (n < count && this->index < this->count) {
+        records[n].address = this->generate(records[n].store);
+        records[n].core = 0;
+        this->index += 1;
+        n += 1;
+    }
+    return n;
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include "record.hh"
+#include "source.hh"
+#include "types.hh"
+
+// Synthetic access patterns with a fixed seed, so every run of the same
+// pattern, count and seed yields the same accesses
+class Generator: public Source {
+    private:
+        u8 pattern;
+        u64 count;
+        u64 index;
+        u64 parameter;
+        u64 state;
+        u32 center;
+        u64 current;
+        Vector<u32> chain;
+        f64 zeta;
+        f64 alpha;
+        f64 eta;
+        u64 next();
+        f64 uniform();
+        bool store(u32);
+        u32 generate(bool&);
+        void prepare_zipf();
+        void prepare_chase();
+
+    public:
+        Generator(const String&, u64, u64);
+        u64 read(Record*, u64);
+};
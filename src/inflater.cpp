@@ -0,0 +1,247 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <zlib.h>
+#ifdef CACHESIM_ZSTD
+#include <zstd.h>
+#endif
+#include "consts.hh"
+#include "exceptions.hh"
+#include "inflater.hh"
+#include "ring.hh"
+#include "types.hh"
+using namespace std;
+
+Inflater::Inflater(const String &path, u8 format, const char *input, u64 size, int descriptor):
+    ring(consts::INFLATE_SLOTS, consts::BLOCK_SIZE) {
+    this->path = path;
+    this->format = format;
+    this->input = (const u8*)input;
+    this->input_size = size;
+    this->descriptor = descriptor;
+    this->buffer = Vector<u8>();
+    this->current = NULL;
+    this->offset = 0;
+    this->stopped.store(false);
+    this->error = nullptr;
+
+    // A mapped file is decompressed in place, while the bytes already read
+    // from a stream are copied ahead of the rest of it
+    if (descriptor >= 0) {
+        this->buffer.resize(max(size, consts::BLOCK_SIZE));
+        memcpy(this->buffer.data(), input, size);
+        this->input = this->buffer.data();
+    }
+    this->thread = Thread(&Inflater::run, this);
+}
+
+Inflater::~Inflater() {
+    // Drain the ring so a thread that is still decompressing can stop
+    this->stopped.store(true);
+    if (this->current != NULL) {
+        this->ring.release();
+        this->current = NULL;
+    }
+    while (this->ring.front() != NULL) {
+        this->ring.release();
+    }
+    this->thread.join();
+}
+
+u8 Inflater::detect(const char *data, u64 size) {
+    // Compressed files are recognized by their magic numbers
+    auto *bytes = (const u8*)data;
+    if (size >= 2 && bytes[0] == 0x1F && bytes[1] == 0x8B) {
+        return consts::GZIP;
+    } else if (size >= 4 && bytes[0] == 0x28 && bytes[1] == 0xB5 && bytes[2] == 0x2F && bytes[3] == 0xFD) {
+        return consts::ZSTD;
+    }
+    return consts::PLAIN;
+}
+
+u64 Inflater::read(char *data, u64 size) {
+    // Copy out of the published blocks, returns 0 once the file is exhausted
+    u64 n = 0;
+    while (n < size) {
+        if (this->current == NULL) {
+            this->current = this->ring.front();
+            this->offset = 0;
+            if (this->current == NULL) {
+                // Report a failure once everything before it was read
+                if (this->error != nullptr) {
+                    rethrow_exception(this->error);
+                }
+                break;
+            }
+        }
+        auto bytes = min(size - n, this->current->count - this->offset);
+        memcpy(data + n, this->current->items.data() + this->offset, bytes);
+        n += bytes;
+        this->offset += bytes;
+        if (this->offset == this->current->count) {
+            this->ring.release();
+            this->current = NULL;
+        }
+    }
+    return n;
+}
+
+bool Inflater::next(const u8 *&data, u64 &size) {
+    // Bytes in memory come first, in blocks so each fits the decompressor's
+    // 32-bit counts
+    if (this->input_size > 0) {
+        data = this->input;
+        size = min(this->input_size, consts::BLOCK_SIZE);
+        this->input += size;
+        this->input_size -= size;
+        return true;
+    } else if (this->descriptor < 0) {
+        return false;
+    }
+
+    // Then the rest of the stream
+    this->buffer.resize(consts::BLOCK_SIZE);
+    while (true) {
+        auto bytes = ::read(this->descriptor, this->buffer.data(), this->buffer.size());
+        if (bytes < 0 && errno == EINTR) {
+            continue;
+        } else if (bytes < 0) {
+            auto sb = StringBuilder();
+            sb << "'" << this->path << "' could not be read";
+            throw IoException(sb.str());
+        } else if (bytes == 0) {
+            return false;
+        }
+        data = this->buffer.data();
+        size = bytes;
+        return true;
+    }
+}
+
+void Inflater::run() {
+    try {
+        if (this->format == consts::GZIP) {
+            this->run_gzip();
+        } else {
+            this->run_zstd();
+        }
+    } catch (...) {
+        this->error = current_exception();
+    }
+    this->ring.close();
+}
+
+void Inflater::run_gzip() {
+    // Accept gzip (and zlib) headers
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    if (inflateInit2(&stream, 15 + 32) != Z_OK) {
+        this->fail("could not be decompressed");
+    }
+    bool open = false;
+    bool ended = false;
+    bool done = false;
+    try {
+        while (!done && !this->stopped.load(memory_order_relaxed)) {
+            auto &batch = this->ring.acquire();
+            stream.next_out = (Bytef*)batch.items.data();
+            stream.avail_out = (uInt)batch.items.size();
+            while (stream.avail_out > 0) {
+                if (stream.avail_in == 0 && !ended) {
+                    const u8 *data = NULL;
+                    u64 size = 0;
+                    ended = !this->next(data, size);
+                    stream.next_in = (Bytef*)data;
+                    stream.avail_in = (uInt)size;
+                }
+
+                // Pending output is flushed after the input runs out
+                auto before = stream.avail_out;
+                auto status = inflate(&stream, Z_NO_FLUSH);
+                if (status == Z_STREAM_END) {
+                    // Concatenated members are decompressed as one file (like gzip)
+                    open = false;
+                    inflateReset(&stream);
+                } else if (status != Z_OK && status != Z_BUF_ERROR) {
+                    this->fail("could not be decompressed");
+                } else if (ended && stream.avail_out == before) {
+                    done = true;
+                    break;
+                } else {
+                    open = true;
+                }
+            }
+            batch.count = batch.items.size() - stream.avail_out;
+            if (batch.count > 0) {
+                this->ring.publish();
+            }
+        }
+        if (done && open) {
+            this->fail("is truncated");
+        }
+    } catch (...) {
+        inflateEnd(&stream);
+        throw;
+    }
+    inflateEnd(&stream);
+}
+
+void Inflater::run_zstd() {
+#ifdef CACHESIM_ZSTD
+    auto *stream = ZSTD_createDStream();
+    if (stream == NULL || ZSTD_isError(ZSTD_initDStream(stream))) {
+        ZSTD_freeDStream(stream);
+        this->fail("could not be decompressed");
+    }
+    ZSTD_inBuffer in = {NULL, 0, 0};
+    size_t status = 0;
+    bool ended = false;
+    bool done = false;
+    try {
+        while (!done && !this->stopped.load(memory_order_relaxed)) {
+            auto &batch = this->ring.acquire();
+            ZSTD_outBuffer out = {batch.items.data(), batch.items.size(), 0};
+            while (out.pos < out.size) {
+                if (in.pos == in.size && !ended) {
+                    const u8 *data = NULL;
+                    u64 size = 0;
+                    ended = !this->next(data, size);
+                    in = ZSTD_inBuffer{data, size, 0};
+                }
+
+                // Zero once a frame is complete (later frames continue the
+                // file), pending output is flushed after the input runs out
+                auto before = out.pos;
+                auto result = ZSTD_decompressStream(stream, &out, &in);
+                if (ZSTD_isError(result)) {
+                    this->fail("could not be decompressed");
+                } else if (ended && out.pos == before) {
+                    done = true;
+                    break;
+                }
+                status = result;
+            }
+            batch.count = out.pos;
+            if (batch.count > 0) {
+                this->ring.publish();
+            }
+        }
+        if (done && status != 0) {
+            this->fail("is truncated");
+        }
+    } catch (...) {
+        ZSTD_freeDStream(stream);
+        throw;
+    }
+    ZSTD_freeDStream(stream);
+#else
+    this->fail("is zstd compressed, which this build doesn't support");
+#endif
+}
+
+void Inflater::fail(const char *message) {
+    auto sb = StringBuilder();
+    sb << "'" << this->path << "' " << message;
+    throw FormatException(sb.str());
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <exception>
+#include "ring.hh"
+#include "types.hh"
+
+// Decompresses a gzip (or zstd) access file on its own thread, handing blocks
+// of decompressed bytes to the reader through a ring so memory stays bounded
+class Inflater {
+    private:
+        String path;
+        u8 format;
+        const u8 *input;
+        u64 input_size;
+        int descriptor;
+        Vector<u8> buffer;
+        Ring<char> ring;
+        Batch<char> *current;
+        u64 offset;
+        Atomic<bool> stopped;
+        std::exception_ptr error;
+        Thread thread;
+        void run();
+        void run_gzip();
+        void run_zstd();
+        bool next(const u8*&, u64&);
+        void fail(const char*);
+
+    public:
+        static u8 detect(const char*, u64);
+        Inflater(const String&, u8, const char*, u64, int);
+        ~Inflater();
+        Inflater(const Inflater&) = delete;
+        Inflater& operator=(const Inflater&) = delete;
+        u64 read(char*, u64);
+};
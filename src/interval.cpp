@@ -0,0 +1,97 @@
+#include <iostream>
+#include "exceptions.hh"
+#include "interval.hh"
+#include "types.hh"
+using namespace std;
+
+Interval::Interval(u64 length, const String &path, bool json) {
+    // Rows go to standard error unless a path is given
+    this->length = length;
+    this->json = json;
+    this->out = &cerr;
+    this->index = 0;
+    this->accesses = 0;
+    this->time = Clock::now();
+    this->last = Vector<Reading>();
+    this->started = false;
+    if (!path.empty()) {
+        this->file = FileWriter(path, FileWriter::trunc);
+        if (!this->file) {
+            auto sb = StringBuilder();
+            sb << "'" << path << "' could not be opened";
+            throw IoException(sb.str());
+        }
+        this->out = &this->file;
+    }
+    if (!json) {
+        *this->out << "interval,accesses,level,hits,misses,writebacks,time,seconds,accesses_per_second\n";
+    }
+}
+
+u64 Interval::get_length() {
+    return this->length;
+}
+
+void Interval::start(u64 accesses, const Vector<Reading> &readings) {
+    // The first interval starts from the counters before the run (which a
+    // restored snapshot may have set)
+    if (!this->started) {
+        this->started = true;
+        this->accesses = accesses;
+        this->time = Clock::now();
+        this->last = readings;
+    }
+}
+
+void Interval::take(u64 accesses, const Vector<Reading> &readings) {
+    // Only a few counters per level, so rows are cheap to take (a run that
+    // ends with an interval has nothing left for another row)
+    if (accesses == this->accesses) {
+        return;
+    }
+    auto now = Clock::now();
+    auto seconds = chrono::duration<f64>(now - this->time).count();
+    auto count = accesses - this->accesses;
+    auto rate = (u64)(seconds > 0 ? count / seconds : 0);
+    this->index += 1;
+    auto &out = *this->out;
+    if (this->json) {
+        out << "{\"interval\":" << this->index
+            << ",\"accesses\":" << accesses
+            << ",\"seconds\":" << seconds
+            << ",\"accesses_per_second\":" << rate
+            << ",\"levels\":[";
+    }
+    for (u32 i = 0; i < readings.size(); i++) {
+        auto &reading = readings[i];
+        auto &last = this->last[i];
+        auto hits = reading.hit_count - last.hit_count;
+        auto misses = reading.miss_count - last.miss_count;
+        auto writebacks = reading.writeback_count - last.writeback_count;
+        auto time = reading.access_time - last.access_time;
+        if (this->json) {
+            out << (i > 0 ? "," : "")
+                << "{\"level\":\"" << reading.label << "\""
+                << ",\"hits\":" << hits
+                << ",\"misses\":" << misses
+                << ",\"writebacks\":" << writebacks
+                << ",\"time\":" << time << "}";
+        } else {
+            out << this->index << "," << accesses << "," << reading.label << ","
+                << hits << "," << misses << "," << writebacks << "," << time << ","
+                << seconds << "," << rate << "\n";
+        }
+    }
+    if (this->json) {
+        out << "]}\n";
+    }
+    out.flush();
+    this->accesses = accesses;
+    this->time = now;
+    this->last = readings;
+}
+
+void Interval::restart(const Vector<Reading> &readings) {
+    // The counters were cleared (e.g. at the end of the warm up)
+    this->last = readings;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <chrono>
+#include "types.hh"
+
+// The counters of one level at one point of the run
+struct Reading {
+    String label;
+    u64 hit_count;
+    u64 miss_count;
+    u64 writeback_count;
+    u64 access_time;
+};
+
+// Writes what every level did during each interval of the run (the change in
+// its counters) with the host throughput, as CSV rows (one per level) or JSON
+// lines (one per interval). Rows are written as they are taken, so a long run
+// can be followed while it goes.
+class Interval {
+    private:
+        using Clock = std::chrono::steady_clock;
+        u64 length;
+        bool json;
+        FileWriter file;
+        std::ostream *out;
+        u64 index;
+        u64 accesses;
+        Clock::time_point time;
+        Vector<Reading> last;
+        bool started;
+
+    public:
+        Interval(u64, const String&, bool);
+        u64 get_length();
+        void start(u64, const Vector<Reading>&);
+        void take(u64, const Vector<Reading>&);
+        void restart(const Vector<Reading>&);
+};
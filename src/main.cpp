@@ -1,34 +1,249 @@
 #include <iostream>
+#include "config.hh"
+#include "events.hh"
+#include "consts.hh"
 #include "exceptions.hh"
+#include "generator.hh"
 #include "memory.hh"
+#include "options.hh"
+#include "reader.hh"
+#include "record.hh"
+#include "source.hh"
 #include "status.hh"
+#include "sweep.hh"
+#include "text.hh"
+#include "writer.hh"
 using namespace std;
 
-int main(int argc, char *argv[]) {
-    // Parse the arguments
-    if (argc < 3) {
-        cerr << "usage: cachesim conf access" << endl;
-        return status::USAGE;
+int usage() {
+    cerr << "usage: cachesim [--curve] [--classify] [--assoc ways] [--sample-sets 1/n] [--threads n] [--batch records]" << endl
+        << "                [--epoch accesses] [--warmup accesses] [--restore snapshot] [--save snapshot] [--log path [--binary]]" << endl
+        << "                [--interval accesses [--stats path] [--json]] conf access" << endl
+        << "       cachesim convert access trace" << endl
+        << "       cachesim gen [--seed n] pattern[:parameter] count conf" << endl
+        << "       cachesim gen [--seed n] [--binary] --output path pattern[:parameter] count" << endl;
+    return status::USAGE;
+}
+
+void save(Source &source, const String &output, bool binary) {
+    // Write the accesses as a binary trace or as an access file
+    auto records = Vector<Record>(consts::BATCH_SIZE);
+    if (binary) {
+        Writer writer(output);
+        while (auto count = source.read(records.data(), records.size())) {
+            writer.write(records.data(), count);
+        }
+        writer.close();
+        return;
+    }
+    auto file = FileWriter(output, FileWriter::trunc);
+    if (!file) {
+        auto sb = StringBuilder();
+        sb << "'" << output << "' could not be opened";
+        throw IoException(sb.str());
+    }
+    while (auto count = source.read(records.data(), records.size())) {
+        for (u64 i = 0; i < count; i++) {
+            file << (records[i].store ? "st " : "ld ") << records[i].address;
+            if (records[i].core != 0) {
+                file << " " << records[i].core;
+            }
+            file << "\n";
+        }
+    }
+    file.close();
+    if (!file) {
+        auto sb = StringBuilder();
+        sb << "'" << output << "' could not be written";
+        throw IoException(sb.str());
+    }
+}
+
+int convert(String &input, String &output) {
+    // Re-encode the access file as a binary trace
+    try {
+        Reader reader(input);
+        save(reader, output, true);
+    } catch (RuntimeException &e) {
+        cerr << e.what() << endl;
+        return status::CONVERT;
+    }
+    return status::OKAY;
+}
+
+int sweep(Options &options, Config &config, Function<Shared<Source>()> &open) {
+    // Run every configuration of the sweep over one decoded trace
+    if (!options.get_save().empty() || !options.get_restore().empty()) {
+        cerr << "snapshots require a single configuration" << endl;
+        return status::SNAPSHOT;
+    }
+    if (!options.get_log().empty()) {
+        cerr << "'--log' requires a single configuration" << endl;
+        return status::CONF;
     }
-    auto conf = String(argv[1]);
-    auto access = String(argv[2]);
+    if (options.get_interval() > 0) {
+        cerr << "'--interval' requires a single configuration" << endl;
+        return status::CONF;
+    }
+    try {
+        Sweep sweep(config);
+        sweep.set_warmup(options.get_warmup());
+        sweep.access(*open());
+        sweep.score();
+    } catch (RuntimeException &e) {
+        cerr << e.what() << endl;
+        return status::ACCESS;
+    }
+    return status::OKAY;
+}
+
+int simulate(Options &options, String &conf, Function<Shared<Source>()> open) {
+    auto config = Config();
     auto memory = Memory();
 
-    // Parse the configuration file
+    // Parse the configuration file (value lists and ranges start a sweep)
     try {
-        memory.conf(conf);
+        config.parse(conf);
+        if (config.size() > 1) {
+            return sweep(options, config, open);
+        }
+        memory.conf(config, 0);
+        if (!memory.is_feasible()) {
+            // e.g. a replacement policy that does not suit the geometry
+            throw FormatException("configuration is not feasible");
+        }
+        if (options.get_curve()) {
+            memory.enable_curve();
+        }
+        if (options.get_assoc() > 0) {
+            memory.enable_associativity(options.get_assoc());
+        }
+        if (options.get_sample_rate() > 0) {
+            memory.enable_sampling(options.get_sample_rate());
+        }
+        if (options.get_classify()) {
+            memory.enable_classification();
+        }
+        memory.set_thread_count(options.get_threads());
+        memory.set_batch_size(options.get_batch_size());
+        memory.set_epoch(options.get_epoch());
+        memory.set_warmup(options.get_warmup());
+        if (!options.get_save().empty() || !options.get_restore().empty()) {
+            memory.enable_snapshots();
+        }
+        if (options.get_interval() > 0) {
+            memory.enable_intervals(options.get_interval(), options.get_stats(), options.get_json());
+        }
+        if (!options.get_log().empty()) {
+#ifdef CACHESIM_EVENTS
+            events::open(options.get_log(), options.get_binary());
+#else
+            throw RuntimeException("'--log' requires a build with events (make EVENTS=1)");
+#endif
+        }
     } catch (RuntimeException &e) {
         cerr << e.what() << endl;
         return status::CONF;
     }
 
-    // Parse and execute the access file
+    // Continue from a saved hierarchy
     try {
-        memory.access(access);
+        if (!options.get_restore().empty()) {
+            memory.restore(options.get_restore());
+        }
+    } catch (RuntimeException &e) {
+        cerr << e.what() << endl;
+        return status::SNAPSHOT;
+    }
+
+    // Parse and execute the accesses
+    try {
+        memory.access(*open());
+#ifdef CACHESIM_EVENTS
+        if (!options.get_log().empty()) {
+            events::close();
+        }
+#endif
     } catch (RuntimeException &e) {
         cerr << e.what() << endl;
         return status::ACCESS;
     }
+    try {
+        if (!options.get_save().empty()) {
+            memory.save(options.get_save());
+        }
+    } catch (RuntimeException &e) {
+        cerr << e.what() << endl;
+        return status::SNAPSHOT;
+    }
     memory.score();
     return status::OKAY;
 }
+
+int gen(Options &options, Vector<String> &args) {
+    // Feed a synthetic pattern straight into the simulator (or write it out
+    // with '--output')
+    auto &output = options.get_output();
+    if (args.size() < (output.empty() ? 4 : 3)) {
+        return usage();
+    }
+    u64 count = 0;
+    try {
+        count = args[2][0] != '-' ? stoull(args[2]) : 0;
+    } catch (Exception &e) {
+    }
+    if (count == 0) {
+        cerr << "'count' requires a positive number" << endl;
+        return usage();
+    }
+    auto generator = Shared<Source>();
+    try {
+        generator = Shared<Source>(new Generator(args[1], count, options.get_seed()));
+        if (!output.empty()) {
+            save(*generator, output, options.get_binary());
+            return status::OKAY;
+        }
+    } catch (RuntimeException &e) {
+        cerr << e.what() << endl;
+        return status::GEN;
+    }
+    return simulate(
+        options,
+        args[3],
+        [&generator]() {
+            return generator;
+        }
+    );
+}
+
+int main(int argc, char *argv[]) {
+    // Parse the arguments
+    auto options = Options();
+    try {
+        options.parse(argc, argv);
+    } catch (RuntimeException &e) {
+        cerr << e.what() << endl;
+        return usage();
+    }
+    auto &args = options.get_arguments();
+    if (args.size() < 2) {
+        return usage();
+    }
+    if (args[0].compare(text::CONVERT) == 0) {
+        if (args.size() < 3) {
+            return usage();
+        }
+        return convert(args[1], args[2]);
+    }
+    if (args[0].compare(text::GEN) == 0) {
+        return gen(options, args);
+    }
+    auto access = args[1];
+    return simulate(
+        options,
+        args[0],
+        [&access]() {
+            return Shared<Source>(new Reader(access));
+        }
+    );
+}
@@ -0,0 +1,144 @@
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CACHESIM_X86
+#endif
+#include "consts.hh"
+#include "match.hh"
+#include "types.hh"
+
+namespace match {
+    static u64 lines_scalar(const u64 *lines, u32 count, u64 value, u64 mask) {
+        u64 bits = 0;
+        for (u32 i = 0; i < count; i++) {
+            bits |= (u64)((lines[i] | mask) == value) << i;
+        }
+        return bits;
+    }
+
+    static u64 ranks_scalar(const u32 *ages, u32 count, u32 rank) {
+        u64 bits = 0;
+        for (u32 i = 0; i < count; i++) {
+            bits |= (u64)(ages[i] >= rank) << i;
+        }
+        return bits;
+    }
+
+#ifdef CACHESIM_X86
+    static u64 lines_sse2(const u64 *lines, u32 count, u64 value, u64 mask) {
+        // SSE2 only compares 32-bit lanes, so both halves of a line must match
+        auto values = _mm_set1_epi64x((long long)value);
+        auto masks = _mm_set1_epi64x((long long)mask);
+        u64 bits = 0;
+        u32 i = 0;
+        for (; i + 2 <= count; i += 2) {
+            auto line = _mm_or_si128(_mm_loadu_si128((const __m128i*)(lines + i)), masks);
+            auto equal = _mm_cmpeq_epi32(line, values);
+            equal = _mm_and_si128(equal, _mm_shuffle_epi32(equal, _MM_SHUFFLE(2, 3, 0, 1)));
+            bits |= (u64)_mm_movemask_pd(_mm_castsi128_pd(equal)) << i;
+        }
+        if (i < count) {
+            bits |= lines_scalar(lines + i, count - i, value, mask) << i;
+        }
+        return bits;
+    }
+
+    static u64 ranks_sse2(const u32 *ages, u32 count, u32 rank) {
+        // Ranks never exceed the way count, so the signed compare is exact
+        auto bound = _mm_set1_epi32((int)rank - 1);
+        u64 bits = 0;
+        u32 i = 0;
+        for (; i + 4 <= count; i += 4) {
+            auto above = _mm_cmpgt_epi32(_mm_loadu_si128((const __m128i*)(ages + i)), bound);
+            bits |= (u64)_mm_movemask_ps(_mm_castsi128_ps(above)) << i;
+        }
+        if (i < count) {
+            bits |= ranks_scalar(ages + i, count - i, rank) << i;
+        }
+        return bits;
+    }
+
+    __attribute__((target("avx2")))
+    static u64 lines_avx2(const u64 *lines, u32 count, u64 value, u64 mask) {
+        auto values = _mm256_set1_epi64x((long long)value);
+        auto masks = _mm256_set1_epi64x((long long)mask);
+        u64 bits = 0;
+        u32 i = 0;
+        for (; i + 4 <= count; i += 4) {
+            auto line = _mm256_or_si256(_mm256_loadu_si256((const __m256i*)(lines + i)), masks);
+            auto equal = _mm256_cmpeq_epi64(line, values);
+            bits |= (u64)_mm256_movemask_pd(_mm256_castsi256_pd(equal)) << i;
+        }
+        if (i < count) {
+            bits |= lines_scalar(lines + i, count - i, value, mask) << i;
+        }
+        return bits;
+    }
+
+    __attribute__((target("avx2")))
+    static u64 ranks_avx2(const u32 *ages, u32 count, u32 rank) {
+        auto bound = _mm256_set1_epi32((int)rank - 1);
+        u64 bits = 0;
+        u32 i = 0;
+        for (; i + 8 <= count; i += 8) {
+            auto above = _mm256_cmpgt_epi32(_mm256_loadu_si256((const __m256i*)(ages + i)), bound);
+            bits |= (u64)_mm256_movemask_ps(_mm256_castsi256_ps(above)) << i;
+        }
+        if (i < count) {
+            bits |= ranks_scalar(ages + i, count - i, rank) << i;
+        }
+        return bits;
+    }
+#endif
+
+    static u8 best() {
+#ifdef CACHESIM_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            return consts::AVX2;
+        } else if (__builtin_cpu_supports("sse2")) {
+            return consts::SSE2;
+        }
+#endif
+        return consts::SCALAR;
+    }
+
+    u8 kernel = consts::SCALAR;
+    u64 (*lines)(const u64*, u32, u64, u64) = lines_scalar;
+    u64 (*ranks)(const u32*, u32, u32) = ranks_scalar;
+
+    bool is_supported(u8 kernel) {
+        return kernel == consts::SCALAR || (kernel <= best() && kernel <= consts::AVX2);
+    }
+
+    void select(u8 kernel) {
+        // Unsupported kernels fall back to the scalar one
+        if (!is_supported(kernel)) {
+            kernel = consts::SCALAR;
+        }
+        match::kernel = kernel;
+#ifdef CACHESIM_X86
+        if (kernel == consts::AVX2) {
+            lines = lines_avx2;
+            ranks = ranks_avx2;
+            return;
+        } else if (kernel == consts::SSE2) {
+            lines = lines_sse2;
+            ranks = ranks_sse2;
+            return;
+        }
+#endif
+        lines = lines_scalar;
+        ranks = ranks_scalar;
+    }
+
+    u8 get_kernel() {
+        return kernel;
+    }
+
+    // Pick the widest kernel before any set is searched
+    struct Startup {
+        Startup() {
+            select(best());
+        }
+    } startup;
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include "types.hh"
+
+// Compares a whole block of a set at once and returns a bitmask with bit 'i'
+// set for every matching way (up to 'MATCH_WIDTH' ways per call). The kernel
+// is the widest one the processor supports, checked once at start up.
+namespace match {
+    // Ways whose line with 'mask' set equals 'value' (the hit is 'value' with
+    // the tag and valid bit and 'mask' the dirty bit, a free way is 'value'
+    // and 'mask' everything but the valid bit)
+    extern u64 (*lines)(const u64*, u32, u64, u64);
+
+    // Ways ranked at least 'rank' (the LRU victim of ranked sets)
+    extern u64 (*ranks)(const u32*, u32, u32);
+
+    bool is_supported(u8);
+    void select(u8);
+    u8 get_kernel();
+}
@@ -1,7 +1,18 @@
 #include <algorithm>
-#include "chars.hh"
+#include <exception>
+#include <iostream>
+#include "config.hh"
+#include "consts.hh"
+#include "directory.hh"
 #include "exceptions.hh"
 #include "memory.hh"
+#include "pool.hh"
+#include "port.hh"
+#include "reader.hh"
+#include "record.hh"
+#include "ring.hh"
+#include "snapshot.hh"
+#include "source.hh"
 #include "text.hh"
 #include "types.hh"
 #include "unit.hh"
@@ -9,62 +20,88 @@ using namespace std;
 
 Memory::Memory() {
     this->unit = NULL;
+    this->cores = Vector<Unit*>();
+    this->ports = Vector<Port*>();
+    this->lanes = Vector<Vector<u32>>();
+    this->directory = NULL;
+    this->interval = NULL;
+    this->next_row = 0;
+    this->thread_count = 1;
+    this->batch_size = consts::BATCH_SIZE;
+    this->epoch = consts::EPOCH_SIZE;
+    this->warmup = 0;
+    this->executed = 0;
 }
 
 Memory::~Memory() {
     if (this->unit != NULL) {
         delete this->unit;
     }
+    for (auto *core: this->cores) {
+        delete core;
+    }
+    if (this->directory != NULL) {
+        delete this->directory;
+    }
+    if (this->interval != NULL) {
+        delete this->interval;
+    }
 }
 
 void Memory::conf(String &path) {
-    // Load the configuration
-    auto file = FileReader(path);
-    auto vec = Vector<Unit*>();
-    if (file) {
-        String key, value;
-        auto buffer = String();
-        auto *unit = new Unit();
-        while (!file.eof()) {
-            auto c = chars::normalize(file.get());
-            if (c == chars::LF || file.eof()) {
-                if (key.length() > 0) {
-                    // The end of a key-value pair has been reached
-                    value = buffer;
-                    buffer.clear();
-                    // Evaluate the key-value pair
-                    try {
-                        unit->set(key, value);
-                    } catch (FormatException &e) {
-                        auto sb = StringBuilder();
-                        sb << e.what() << " in '" << path << "'";
-                        throw FormatException(sb.str());
-                    }
-                    key.clear();
-                    value.clear();
-                }
-            } else if (c == chars::COLON) {
-                // The end of a key has been reached
-                if (buffer.compare(text::LEVEL) == 0 && unit->is_valid()) {
-                    vec.push_back(unit);
-                    unit = new Unit();
-                }
-                key = buffer;
-                buffer.clear();
-            } else if (chars::is_alphanum(c)) {
-                // Push alphabetic characters only
-                buffer.push_back(c);
+    auto config = Config();
+    config.parse(path);
+    if (config.size() > 1) {
+        auto sb = StringBuilder();
+        sb << "'" << path << "' describes a sweep";
+        throw FormatException(sb.str());
+    }
+    this->conf(config, 0);
+}
+
+void Memory::conf(Config &config, u64 index) {
+    // Build the hierarchy for one configuration of the sweep
+    auto vec = this->build(config, index);
+
+    // Levels with cores are private to every core and sit above the shared
+    // levels
+    u32 private_count = 0;
+    while (private_count < vec.size() && vec[private_count]->get_core_count() > 0) {
+        private_count += 1;
+    }
+    for (u32 i = 0; i < vec.size(); i++) {
+        auto cores = vec[i]->get_core_count();
+        if (
+            (i < private_count && (cores != vec[0]->get_core_count() || vec[i]->get_organisation() == consts::MAIN_MEMORY)) ||
+            (i >= private_count && cores > 0) ||
+            private_count == vec.size()
+        ) {
+            for (auto *unit: vec) {
+                delete unit;
             }
+            throw FormatException("private levels must be the first cache levels and have the same core count");
         }
-        vec.push_back(unit);
-        file.close();
-    } else {
-        auto sb = StringBuilder();
-        sb << "'" << path << "' could not be opened";
-        throw IoException(sb.str());
+    }
+    this->unit = vec[private_count];
+
+    // Finalize the hierarcy
+    for (Unit *unit: vec) {
+        unit->finalize();
+    }
+    for (auto i = private_count + 1; i < vec.size(); i++) {
+        this->unit->add_unit(vec[i]);
+    }
+    if (private_count > 0) {
+        this->build_cores(config, index, vec, private_count);
     }
 
-    // Sort the hierarchy
+    // Bind the specialized access engines
+    this->unit->specialize();
+}
+
+Vector<Unit*> Memory::build(Config &config, u64 index) {
+    // Build and sort the hierarchy
+    auto vec = config.build(index);
     sort(
         vec.begin(),
         vec.end(),
@@ -72,74 +109,469 @@ void Memory::conf(String &path) {
             return *lhs < *rhs;
         }
     );
-    this->unit = vec[0];
+    return vec;
+}
 
-    // Finalize the hierarcy
-    for (Unit *unit: vec) {
-        unit->finalize();
+void Memory::build_cores(Config &config, u64 index, Vector<Unit*> &vec, u32 private_count) {
+    // The directory tracks the lines of the first shared level (or the
+    // largest private lines when main memory is shared)
+    u32 shift = 0;
+    u8 protocol = consts::MESI;
+    for (u32 i = 0; i < vec.size(); i++) {
+        if (i < private_count || vec[i] == this->unit) {
+            shift = max(shift, vec[i]->get_offset_width());
+        }
+        if (vec[i]->get_coherence() != 0) {
+            protocol = vec[i]->get_coherence();
+        }
     }
-    for (auto i = 1; i < vec.size(); i++) {
-        this->unit->add_unit(vec[i]);
+    if (this->unit->get_organisation() != consts::MAIN_MEMORY) {
+        shift = this->unit->get_offset_width();
     }
+    this->directory = new Directory(protocol, shift);
+
+    // Every core gets its own private levels (built from the same
+    // configuration), ending in a port to the shared levels
+    auto count = vec[0]->get_core_count();
+    for (u32 core = 0; core < count; core++) {
+        auto units = core == 0 ? vec : this->build(config, index);
+        for (u32 i = 0; i < units.size(); i++) {
+            if (i >= private_count) {
+                if (core > 0) {
+                    delete units[i];
+                }
+            } else {
+                if (core > 0) {
+                    units[i]->finalize();
+                }
+                if (i > 0) {
+                    units[0]->add_unit(units[i]);
+                }
+            }
+        }
+        auto *port = new Port(shift);
+        auto *end = new Unit();
+        end->set_port(port);
+        units[0]->add_unit(end);
+        units[0]->specialize();
+        this->cores.push_back(units[0]);
+        this->ports.push_back(port);
+    }
+    this->lanes = Vector<Vector<u32>>(count);
 }
 
 void Memory::access(String &path) {
-    auto file = FileReader(path);
-    if (file) {
-        String instr, addr;
-        while (!file.eof()) {
-            file >> instr >> addr;
-            chars::normalize(instr);
-            if (instr.length() > 0) {
-                // Evaluate the instruction
-                try {
-                    this->exec(instr, addr);
-                } catch (FormatException &e) {
-                    auto sb = StringBuilder();
-                    sb << e.what() <<" in '" << path << "'";
-                    throw FormatException(sb.str());
+    // Parse the access file in batches (the reader reports its own errors)
+    Reader reader(path);
+    this->access(reader);
+}
+
+void Memory::access(Source &source) {
+    u32 low = 0;
+    u32 high = 64;
+    this->unit->partition(low, high);
+    if (this->thread_count > 1 && high > low && this->cores.empty()) {
+        this->access_partitioned(source, low, high - low);
+        return;
+    }
+
+    // Decode on a separate thread so parsing overlaps with the simulation
+    // (the source fills batches until the ring is full, and multi-core
+    // batches are whole epochs so the epochs don't depend on the batch size)
+    Ring<Record> ring(consts::RING_SLOTS, this->cores.empty() ? this->batch_size : this->epoch);
+    std::exception_ptr error = nullptr;
+    Atomic<bool> stopped(false);
+    auto producer = Thread(
+        [&source, &ring, &error, &stopped]() {
+            try {
+                while (!stopped.load(std::memory_order_relaxed)) {
+                    auto &batch = ring.acquire();
+                    batch.count = source.read(batch.items.data(), batch.items.size());
+                    if (batch.count == 0) {
+                        break;
+                    }
+                    ring.publish();
+                }
+            } catch (...) {
+                error = std::current_exception();
+            }
+            ring.close();
+        }
+    );
+    try {
+        while (auto *batch = ring.front()) {
+            this->exec(batch->items.data(), batch->count);
+            ring.release();
+        }
+    } catch (...) {
+        // Stop the decoder (e.g. after an access from a missing core)
+        stopped.store(true);
+        while (ring.front() != NULL) {
+            ring.release();
+        }
+        producer.join();
+        throw;
+    }
+    producer.join();
+
+    // The last interval ends with the run
+    if (this->interval != NULL) {
+        auto forks = Vector<Shared<Unit>>();
+        this->interval->take(this->executed, this->read(forks));
+    }
+
+    // Report a decoding failure (everything before it was simulated)
+    if (error != nullptr) {
+        std::rethrow_exception(error);
+    }
+}
+
+void Memory::access_partitioned(Source &source, u32 shift, u32 bits) {
+    // Every level indexes its sets with the bits at 'shift', so the accesses
+    // (and the write backs they cause) never cross between shards. Each
+    // shard replays its records in order on a fork of the hierarchy that
+    // shares the lines, and the counters are merged at the end.
+    Pool pool(this->thread_count);
+    u32 width = 0;
+    while (width < bits && (1U << width) < consts::SHARDS_PER_THREAD * pool.get_thread_count()) {
+        width += 1;
+    }
+    auto mask = (1ULL << width) - 1;
+    this->unit->reserve();
+    auto forks = Vector<Shared<Unit>>();
+    auto shards = Vector<Vector<Record>>(1U << width);
+    for (u32 i = 0; i < shards.size(); i++) {
+        forks.push_back(Shared<Unit>(this->unit->fork()));
+    }
+
+    // Shard and replay one batch at a time (the batch is cut short at the
+    // end of the warm up and of every interval so every fork can be reset
+    // and counted in step)
+    auto records = Vector<Record>(consts::SHARD_BATCH);
+    if (this->interval != NULL) {
+        this->interval->start(this->executed, this->read(forks));
+    }
+    while (true) {
+        auto limit = (u64)records.size();
+        if (this->executed < this->warmup) {
+            limit = min(limit, this->warmup - this->executed);
+        }
+        if (this->interval != NULL) {
+            limit = min(limit, this->next_row - this->executed);
+        }
+        auto count = source.read(records.data(), limit);
+        if (count == 0) {
+            break;
+        }
+        for (auto &shard: shards) {
+            shard.clear();
+        }
+        for (u64 i = 0; i < count; i++) {
+            shards[(records[i].address >> shift) & mask].push_back(records[i]);
+        }
+        pool.run(
+            shards.size(),
+            [&forks, &shards](u64 i) {
+                auto *unit = forks[i].get();
+                for (auto &record: shards[i]) {
+                    if (record.store) {
+                        unit->store(record.address);
+                    } else {
+                        unit->load(record.address);
+                    }
                 }
-                // Clear the buffers
-                instr.clear();
-                addr.clear();
             }
+        );
+        this->advance(count, forks);
+    }
+    if (this->interval != NULL) {
+        this->interval->take(this->executed, this->read(forks));
+    }
+    for (auto &fork: forks) {
+        this->unit->merge(fork.get());
+    }
+}
+
+void Memory::exec(const Record *records, u64 count) {
+    // Stop at the end of the warm up and of every interval (multi-core
+    // batches are whole epochs, so their intervals end with an epoch)
+    auto forks = Vector<Shared<Unit>>();
+    if (this->interval != NULL) {
+        this->interval->start(this->executed, this->read(forks));
+    }
+    while (count > 0) {
+        auto step = count;
+        if (this->executed < this->warmup) {
+            step = min(step, this->warmup - this->executed);
         }
-        file.close();
-    } else {
+        if (this->interval != NULL && this->cores.empty()) {
+            step = min(step, this->next_row - this->executed);
+        }
+        this->replay(records, step);
+        this->advance(step, forks);
+        records += step;
+        count -= step;
+    }
+}
+
+void Memory::advance(u64 count, Vector<Shared<Unit>> &forks) {
+    // Reset the statistics once the warm up accesses have been simulated
+    // (forks included) and write a row at the end of every interval
+    this->executed += count;
+    if (this->warmup > 0 && this->executed - count < this->warmup && this->executed >= this->warmup) {
+        this->reset();
+        for (auto &fork: forks) {
+            fork->reset();
+        }
+        if (this->interval != NULL) {
+            this->interval->restart(this->read(forks));
+        }
+    }
+    if (this->interval != NULL && this->executed >= this->next_row) {
+        this->interval->take(this->executed, this->read(forks));
+        this->next_row = (this->executed / this->interval->get_length() + 1) * this->interval->get_length();
+    }
+}
+
+Vector<Reading> Memory::read(Vector<Shared<Unit>> &forks) {
+    // The counters of every level, private levels first (labelled with their
+    // core), with the counters of the forks added in
+    auto readings = Vector<Reading>();
+    for (u32 core = 0; core < this->cores.size(); core++) {
+        for (auto *unit = this->cores[core]; unit->get_next() != NULL; unit = unit->get_next()) {
+            auto label = "C" + to_string(core) + "." + unit->get_label();
+            readings.push_back(Reading{label, unit->get_hit_count(), unit->get_miss_count(), unit->get_writeback_count(), unit->get_access_time()});
+        }
+    }
+    for (auto *unit = this->unit; unit != NULL; unit = unit->get_next()) {
+        readings.push_back(Reading{unit->get_label(), unit->get_hit_count(), unit->get_miss_count(), unit->get_writeback_count(), unit->get_access_time()});
+    }
+    for (auto &fork: forks) {
+        u32 i = 0;
+        for (auto *unit = fork.get(); unit != NULL; unit = unit->get_next(), i++) {
+            readings[i].hit_count += unit->get_hit_count();
+            readings[i].miss_count += unit->get_miss_count();
+            readings[i].writeback_count += unit->get_writeback_count();
+            readings[i].access_time += unit->get_access_time();
+        }
+    }
+    return readings;
+}
+
+void Memory::replay(const Record *records, u64 count) {
+    if (!this->cores.empty()) {
+        // One thread per core, in epochs
+        Pool pool(this->cores.size());
+        for (u64 start = 0; start < count; start += this->epoch) {
+            this->replay_epoch(pool, records + start, min(this->epoch, count - start));
+        }
+        return;
+    }
+    for (u64 i = 0; i < count; i++) {
+        if (records[i].store) {
+            this->store(records[i].address);
+        } else {
+            this->load(records[i].address);
+        }
+    }
+}
+
+void Memory::replay_epoch(Pool &pool, const Record *records, u64 count) {
+    // Deal the accesses out to their cores
+    for (auto &lane: this->lanes) {
+        lane.clear();
+    }
+    for (u64 i = 0; i < count; i++) {
+        if (records[i].core >= this->cores.size()) {
+            auto sb = StringBuilder();
+            sb << "core " << records[i].core << " is out of range (the hierarchy has " << this->cores.size() << " cores)";
+            throw RuntimeException(sb.str());
+        }
+        this->lanes[records[i].core].push_back((u32)i);
+    }
+
+    // Each core runs its private levels on its own thread, queueing whatever
+    // reaches the shared levels
+    pool.run(
+        this->cores.size(),
+        [this, records](u64 core) {
+            auto *unit = this->cores[core];
+            auto *port = this->ports[core];
+            port->clear();
+            for (auto i: this->lanes[core]) {
+                port->begin(i, records[i].address, records[i].store);
+                if (records[i].store) {
+                    unit->store(records[i].address);
+                } else {
+                    unit->load(records[i].address);
+                }
+            }
+        }
+    );
+
+    // Then the directory and the shared levels see the epoch in access order
+    // (coherence acts on the private lines as they are at the end of the
+    // epoch, and each request's time is added to the core's private levels)
+    auto touched = Vector<u64>(this->cores.size());
+    auto requested = Vector<u64>(this->cores.size());
+    for (u64 i = 0; i < count; i++) {
+        auto core = records[i].core;
+        auto &touches = this->ports[core]->get_touches();
+        auto &t = touched[core];
+        if (t < touches.size() && touches[t].sequence == i) {
+            if (touches[t].store) {
+                this->directory->store(core, touches[t].address, this->cores, this->unit);
+            } else {
+                this->directory->load(core, touches[t].address, this->cores, this->unit);
+            }
+            t += 1;
+        }
+        auto &requests = this->ports[core]->get_requests();
+        for (auto &r = requested[core]; r < requests.size() && requests[r].sequence == i; r++) {
+            auto &request = requests[r];
+            auto time = request.store ? this->unit->store(request.address) : this->unit->load(request.address);
+            this->cores[core]->add_time(time);
+        }
+    }
+}
+
+void Memory::enable_curve() {
+    this->require_single("'curve'");
+    if (this->unit->enable_curve() == 0) {
+        throw RuntimeException("'curve' requires a fully associative level");
+    }
+}
+
+void Memory::enable_associativity(u32 way) {
+    this->require_single("'assoc'");
+    if (this->unit->enable_associativity(way) == 0) {
+        throw RuntimeException("'assoc' requires a set associative level with write allocation");
+    }
+}
+
+void Memory::enable_classification() {
+    this->require_single("'classify'");
+    if (this->unit->enable_classification() == 0) {
+        throw RuntimeException("'classify' requires a cache level");
+    }
+}
+
+void Memory::enable_sampling(u32 rate) {
+    this->require_single("'sample-sets'");
+    if (this->unit->enable_sampling(rate) == 0) {
+        throw RuntimeException("'sample-sets' requires a set associative or direct mapped last level");
+    }
+}
+
+void Memory::enable_snapshots() {
+    this->require_single("snapshots");
+    if (this->unit->is_analysed()) {
+        throw RuntimeException("snapshots can't be combined with an analysis or sampling");
+    }
+}
+
+void Memory::require_single(const char *feature) {
+    // Analyses and snapshots only cover a single chain of levels
+    if (!this->cores.empty()) {
         auto sb = StringBuilder();
-        sb << "'" << path << "' could not be opened";
-        throw IoException(sb.str());
+        sb << feature << " requires a hierarchy without private levels";
+        throw RuntimeException(sb.str());
     }
 }
 
-void Memory::exec(String &instr, String &saddr) {
-    u32 uaddr = 0;
+void Memory::set_batch_size(u64 batch_size) {
+    this->batch_size = batch_size;
+}
 
-    // Parse the address
-    try {
-        uaddr = (u32)stoul(saddr);
-    } catch (Exception &e) {
-        throw FormatException("'address' could not be parsed");
+void Memory::set_thread_count(u32 thread_count) {
+    this->thread_count = thread_count;
+}
+
+void Memory::set_warmup(u64 warmup) {
+    this->warmup = warmup;
+    this->executed = 0;
+}
+
+void Memory::enable_intervals(u64 length, const String &path, bool json) {
+    // Intervals are counted from the start of the run
+    this->interval = new Interval(length, path, json);
+    this->next_row = this->executed + length;
+}
+
+void Memory::set_epoch(u64 epoch) {
+    this->epoch = epoch;
+}
+
+void Memory::reset() {
+    // Clear the counters of every level (and the directory)
+    this->unit->reset();
+    for (auto *core: this->cores) {
+        core->reset();
+    }
+    if (this->directory != NULL) {
+        this->directory->reset();
     }
+}
 
-    // Parse the instruction
-    if (instr.compare(text::LOAD) == 0) {
-        this->load(uaddr);
-    } else if (instr.compare(text::STORE) == 0) {
-        this->store(uaddr);
-    } else {
-        throw FormatException("unrecognized instruction");
+void Memory::save(String &path) {
+    SnapshotWriter writer(path);
+    this->unit->save(writer);
+    writer.close();
+}
+
+void Memory::restore(String &path) {
+    SnapshotReader reader(path);
+    this->unit->restore(reader);
+}
+
+bool Memory::is_feasible() {
+    for (auto *core: this->cores) {
+        if (!core->is_feasible()) {
+            return false;
+        }
     }
+    return this->unit->is_feasible();
+}
+
+Unit *Memory::get_unit() {
+    return this->unit;
+}
+
+u32 Memory::get_core_count() {
+    return this->cores.size();
+}
+
+Unit *Memory::get_core(u32 core) {
+    return this->cores[core];
 }
 
 void Memory::score() {
-    this->unit->score();
+    if (this->cores.empty()) {
+        this->unit->score(1.0);
+        return;
+    }
+
+    // Every core's private levels, the shared levels and the coherence
+    // traffic between them
+    for (u32 core = 0; core < this->cores.size(); core++) {
+        cout << "Core: " << core << "\n";
+        this->cores[core]->score(1.0);
+        cout << "\n";
+    }
+    cout << "Shared:" << "\n";
+    this->unit->score(1.0);
+    cout << "\n"
+        << "Coherence: " << (this->directory->get_protocol() == consts::MESI ? "MESI" : "MSI") << "\n"
+        << "  InvalidationCount: " << this->directory->get_invalidation_count()
+        << " InterventionCount: " << this->directory->get_intervention_count()
+        << " UpgradeCount: " << this->directory->get_upgrade_count()
+        << " WritebackCount: " << this->directory->get_writeback_count() << "\n";
 }
 
-void Memory::load(u32 addr) {
+void Memory::load(u64 addr) {
     this->unit->load(addr);
 }
 
-void Memory::store(u32 addr) {
+void Memory::store(u64 addr) {
     this->unit->store(addr);
 }
@@ -1,18 +1,64 @@
 #pragma once
+#include "config.hh"
+#include "directory.hh"
+#include "interval.hh"
+#include "pool.hh"
+#include "port.hh"
+#include "reader.hh"
+#include "record.hh"
+#include "source.hh"
 #include "types.hh"
 #include "unit.hh"
 
 class Memory {
     private:
         Unit *unit;
-        void exec(String&, String&);
-        void load(u32);
-        void store(u32);
+        Vector<Unit*> cores;
+        Vector<Port*> ports;
+        Vector<Vector<u32>> lanes;
+        Directory *directory;
+        Interval *interval;
+        u64 next_row;
+        u32 thread_count;
+        u64 batch_size;
+        u64 epoch;
+        u64 warmup;
+        u64 executed;
+        Vector<Unit*> build(Config&, u64);
+        void build_cores(Config&, u64, Vector<Unit*>&, u32);
+        void replay(const Record*, u64);
+        void replay_epoch(Pool&, const Record*, u64);
+        void access_partitioned(Source&, u32, u32);
+        void require_single(const char*);
+        void advance(u64, Vector<Shared<Unit>>&);
+        Vector<Reading> read(Vector<Shared<Unit>>&);
+        void load(u64);
+        void store(u64);
 
     public:
         Memory();
         ~Memory();
         void conf(String&);
+        void conf(Config&, u64);
         void access(String&);
+        void access(Source&);
+        void exec(const Record*, u64);
+        void enable_curve();
+        void enable_associativity(u32);
+        void enable_sampling(u32);
+        void enable_classification();
+        void enable_snapshots();
+        void enable_intervals(u64, const String&, bool);
+        void set_batch_size(u64);
+        void set_thread_count(u32);
+        void set_warmup(u64);
+        void set_epoch(u64);
+        void save(String&);
+        void restore(String&);
+        void reset();
+        bool is_feasible();
+        Unit *get_unit();
+        u32 get_core_count();
+        Unit *get_core(u32);
         void score();
 };
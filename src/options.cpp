@@ -0,0 +1,177 @@
+#include "consts.hh"
+#include "exceptions.hh"
+#include "options.hh"
+#include "sample.hh"
+#include "text.hh"
+#include "types.hh"
+using namespace std;
+
+Options::Options() {
+    this->arguments = Vector<String>();
+    this->curve = false;
+    this->classify = false;
+    this->assoc = 0;
+    this->sample_rate = 0;
+    this->threads = 1;
+    this->batch_size = consts::BATCH_SIZE;
+    this->seed = 0;
+    this->output = String();
+    this->binary = false;
+    this->warmup = 0;
+    this->save = String();
+    this->restore = String();
+    this->log = String();
+    this->epoch = consts::EPOCH_SIZE;
+    this->interval = 0;
+    this->stats = String();
+    this->json = false;
+}
+
+void Options::parse(int argc, char *argv[]) {
+    // Options may appear anywhere, everything else is positional
+    for (auto i = 1; i < argc; i++) {
+        auto arg = String(argv[i]);
+        if (arg.compare(0, text::OPTION.length(), text::OPTION) != 0) {
+            this->arguments.push_back(arg);
+        } else if (arg.compare(text::CURVE) == 0) {
+            this->curve = true;
+        } else if (arg.compare(text::CLASSIFY) == 0) {
+            this->classify = true;
+        } else if (arg.compare(text::ASSOC) == 0 && i + 1 < argc) {
+            this->assoc = (u32)this->parse_number(arg, argv[++i]);
+        } else if (arg.compare(text::THREADS) == 0 && i + 1 < argc) {
+            this->threads = (u32)this->parse_number(arg, argv[++i]);
+        } else if (arg.compare(text::BATCH) == 0 && i + 1 < argc) {
+            this->batch_size = this->parse_number(arg, argv[++i]);
+        } else if (arg.compare(text::SEED) == 0 && i + 1 < argc) {
+            this->seed = this->parse_seed(arg, argv[++i]);
+        } else if (arg.compare(text::OUTPUT) == 0 && i + 1 < argc) {
+            this->output = argv[++i];
+        } else if (arg.compare(text::BINARY) == 0) {
+            this->binary = true;
+        } else if (arg.compare(text::WARMUP) == 0 && i + 1 < argc) {
+            this->warmup = this->parse_number(arg, argv[++i]);
+        } else if (arg.compare(text::SAVE) == 0 && i + 1 < argc) {
+            this->save = argv[++i];
+        } else if (arg.compare(text::RESTORE) == 0 && i + 1 < argc) {
+            this->restore = argv[++i];
+        } else if (arg.compare(text::LOG) == 0 && i + 1 < argc) {
+            this->log = argv[++i];
+        } else if (arg.compare(text::EPOCH) == 0 && i + 1 < argc) {
+            this->epoch = this->parse_number(arg, argv[++i]);
+        } else if (arg.compare(text::INTERVAL) == 0 && i + 1 < argc) {
+            this->interval = this->parse_number(arg, argv[++i]);
+        } else if (arg.compare(text::STATS) == 0 && i + 1 < argc) {
+            this->stats = argv[++i];
+        } else if (arg.compare(text::JSON) == 0) {
+            this->json = true;
+        } else if (arg.compare(text::SAMPLE_SETS) == 0 && i + 1 < argc) {
+            this->sample_rate = sample::parse_rate(argv[++i]);
+            if (this->sample_rate == 0) {
+                throw FormatException("'--sample-sets' requires a rate such as '1/64'");
+            }
+        } else {
+            auto sb = StringBuilder();
+            sb << "unrecognized option '" << arg << "'";
+            throw FormatException(sb.str());
+        }
+    }
+}
+
+u64 Options::parse_number(const String &option, const String &value) {
+    try {
+        auto number = stoull(value);
+        if (number > 0) {
+            return number;
+        }
+    } catch (Exception &e) {
+    }
+    auto sb = StringBuilder();
+    sb << "'" << option << "' requires a positive number";
+    throw FormatException(sb.str());
+}
+
+u64 Options::parse_seed(const String &option, const String &value) {
+    // Unlike the other numbers, zero is a valid seed
+    try {
+        if (!value.empty() && value[0] != '-') {
+            return stoull(value);
+        }
+    } catch (Exception &e) {
+    }
+    auto sb = StringBuilder();
+    sb << "'" << option << "' requires a number";
+    throw FormatException(sb.str());
+}
+
+Vector<String> &Options::get_arguments() {
+    return this->arguments;
+}
+
+bool Options::get_curve() {
+    return this->curve;
+}
+
+bool Options::get_classify() {
+    return this->classify;
+}
+
+u32 Options::get_assoc() {
+    return this->assoc;
+}
+
+u32 Options::get_sample_rate() {
+    return this->sample_rate;
+}
+
+u32 Options::get_threads() {
+    return this->threads;
+}
+
+u64 Options::get_batch_size() {
+    return this->batch_size;
+}
+
+u64 Options::get_seed() {
+    return this->seed;
+}
+
+String &Options::get_output() {
+    return this->output;
+}
+
+bool Options::get_binary() {
+    return this->binary;
+}
+
+u64 Options::get_warmup() {
+    return this->warmup;
+}
+
+String &Options::get_save() {
+    return this->save;
+}
+
+String &Options::get_restore() {
+    return this->restore;
+}
+
+String &Options::get_log() {
+    return this->log;
+}
+
+u64 Options::get_epoch() {
+    return this->epoch;
+}
+
+u64 Options::get_interval() {
+    return this->interval;
+}
+
+String &Options::get_stats() {
+    return this->stats;
+}
+
+bool Options::get_json() {
+    return this->json;
+}
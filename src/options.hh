@@ -0,0 +1,48 @@
+#pragma once
+#include "types.hh"
+
+class Options {
+    private:
+        Vector<String> arguments;
+        bool curve;
+        bool classify;
+        u32 assoc;
+        u32 sample_rate;
+        u32 threads;
+        u64 batch_size;
+        u64 seed;
+        String output;
+        bool binary;
+        u64 warmup;
+        String save;
+        String restore;
+        String log;
+        u64 epoch;
+        u64 interval;
+        String stats;
+        bool json;
+        u64 parse_number(const String&, const String&);
+        u64 parse_seed(const String&, const String&);
+
+    public:
+        Options();
+        void parse(int, char*[]);
+        Vector<String> &get_arguments();
+        bool get_curve();
+        bool get_classify();
+        u32 get_assoc();
+        u32 get_sample_rate();
+        u32 get_threads();
+        u64 get_batch_size();
+        u64 get_seed();
+        String &get_output();
+        bool get_binary();
+        u64 get_warmup();
+        String &get_save();
+        String &get_restore();
+        String &get_log();
+        u64 get_epoch();
+        u64 get_interval();
+        String &get_stats();
+        bool get_json();
+};
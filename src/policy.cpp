@@ -0,0 +1,186 @@
+#include <algorithm>
+#include "consts.hh"
+#include "match.hh"
+#include "policy.hh"
+#include "storage.hh"
+#include "types.hh"
+using namespace std;
+
+u32 RankedLru::victim(Set &set) {
+    // The least recently used line is ranked 'way - 1'
+    auto *ages = set.get_ages();
+    auto way = set.get_way();
+    if (way >= consts::MATCH_WAY) {
+        for (u32 base = 0; base < way; base += consts::MATCH_WIDTH) {
+            auto bits = match::ranks(ages + base, min(way - base, consts::MATCH_WIDTH), way - 1);
+            if (bits != 0) {
+                return base + __builtin_ctzll(bits);
+            }
+        }
+        return way - 1;
+    }
+    for (u32 i = 0; i < way; i++) {
+        if (ages[i] >= way - 1) {
+            return i;
+        }
+    }
+    return way - 1;
+}
+
+void RankedLru::touch(Set &set, u32 index) {
+    // Age every line that was more recently used than this one (invalid lines
+    // are ranked 'way' and never younger than any line)
+    auto *ages = set.get_ages();
+    auto age = ages[index];
+    for (u32 i = 0; i < set.get_way(); i++) {
+        ages[i] += ages[i] < age;
+    }
+    ages[index] = 0;
+}
+
+void RankedLru::insert(Set &set, u32 index) {
+    RankedLru::touch(set, index);
+}
+
+u32 PackedLru::victim(Set &set) {
+    // Nibble 'p' holds the way at recency position 'p' (zero is the most
+    // recent). The state is stored XOR the identity permutation so a zeroed
+    // set starts out as the identity.
+    auto order = *set.get_state() ^ consts::IDENTITY;
+    return (order >> ((set.get_way() - 1) * 4)) & 0xf;
+}
+
+void PackedLru::touch(Set &set, u32 index) {
+    auto order = *set.get_state() ^ consts::IDENTITY;
+
+    // Find the position of the way (the lowest zero nibble is exact)
+    auto x = order ^ (index * consts::NIBBLES);
+    auto zero = (x - consts::NIBBLES) & ~x & (consts::NIBBLES << 3);
+    auto position = (u32)__builtin_ctzll(zero) >> 2;
+
+    // Shift the more recent ways down and put this way in front
+    auto below = position == 0 ? 0 : order & (~0ULL >> (64 - position * 4));
+    auto above = position == 15 ? 0 : order & (~0ULL << (position * 4 + 4));
+    order = above | below << 4 | index;
+    *set.get_state() = order ^ consts::IDENTITY;
+}
+
+void PackedLru::insert(Set &set, u32 index) {
+    PackedLru::touch(set, index);
+}
+
+u32 TreePlru::victim(Set &set) {
+    // Follow the node bits (zero is left) from the root to a leaf
+    auto *bits = set.get_state();
+    auto way = set.get_way();
+    u32 node = 1;
+    while (node < way) {
+        node = node * 2 + ((bits[node >> 6] >> (node & 63)) & 1);
+    }
+    return node - way;
+}
+
+void TreePlru::touch(Set &set, u32 index) {
+    // Point every node on the path away from the line
+    auto *bits = set.get_state();
+    for (auto node = index + set.get_way(); node > 1; node >>= 1) {
+        auto parent = node >> 1;
+        auto mask = 1ULL << (parent & 63);
+        if (node & 1) {
+            bits[parent >> 6] &= ~mask;
+        } else {
+            bits[parent >> 6] |= mask;
+        }
+    }
+}
+
+void TreePlru::insert(Set &set, u32 index) {
+    TreePlru::touch(set, index);
+}
+
+u32 Srrip::victim(Set &set) {
+    // Find the first line predicted distant (RRPV 3), aging every line until
+    // one is (32 lines per word, 2 bits each)
+    auto *words = set.get_state();
+    auto way = set.get_way();
+    auto count = (way + 31) / 32;
+    while (true) {
+        for (u32 i = 0; i < count; i++) {
+            auto lanes = way - i * 32 >= 32 ? ~0ULL : (1ULL << ((way - i * 32) * 2)) - 1;
+            auto distant = words[i] & (words[i] >> 1) & consts::PAIRS & lanes;
+            if (distant != 0) {
+                return i * 32 + (__builtin_ctzll(distant) >> 1);
+            }
+        }
+        for (u32 i = 0; i < count; i++) {
+            auto lanes = way - i * 32 >= 32 ? ~0ULL : (1ULL << ((way - i * 32) * 2)) - 1;
+            words[i] += consts::PAIRS & lanes;
+        }
+    }
+}
+
+void Srrip::touch(Set &set, u32 index) {
+    // Hits are predicted to be re-referenced soon (RRPV 0)
+    auto &word = set.get_state()[index / 32];
+    word &= ~(3ULL << ((index % 32) * 2));
+}
+
+void Srrip::insert(Set &set, u32 index) {
+    // Fills are predicted to be re-referenced late (RRPV 2)
+    auto &word = set.get_state()[index / 32];
+    word = (word & ~(3ULL << ((index % 32) * 2))) | (2ULL << ((index % 32) * 2));
+}
+
+u32 Fifo::victim(Set &set) {
+    return (u32)*set.get_state();
+}
+
+void Fifo::touch(Set &set, u32 index) {
+    // Hits don't change the order
+}
+
+void Fifo::insert(Set &set, u32 index) {
+    // Lines are filled in order, so the oldest follows the newest
+    *set.get_state() = (index + 1) % set.get_way();
+}
+
+u32 Random::victim(Set &set) {
+    // SplitMix64 finalizer over the set index and the fill count
+    auto x = *set.get_state() * consts::GOLDEN + set.get_index();
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    x = x ^ (x >> 31);
+    return (u32)(x % set.get_way());
+}
+
+void Random::touch(Set &set, u32 index) {
+    // Hits don't change the choice
+}
+
+void Random::insert(Set &set, u32 index) {
+    *set.get_state() += 1;
+}
+
+bool policy::is_supported(u8 replacement, u32 way) {
+    // Tree pseudo-LRU needs a complete tree
+    if (replacement == consts::TREE_PLRU) {
+        return way > 0 && (way & (way - 1)) == 0;
+    }
+    return true;
+}
+
+bool policy::is_ranked(u8 replacement, u32 way) {
+    return replacement == consts::LRU && way > consts::PACKED_WAYS;
+}
+
+u32 policy::get_words(u8 replacement, u32 way) {
+    // Words of packed state per set
+    if (replacement == consts::LRU) {
+        return way > consts::PACKED_WAYS ? 0 : 1;
+    } else if (replacement == consts::TREE_PLRU) {
+        return (way + 63) / 64;
+    } else if (replacement == consts::SRRIP) {
+        return (way + 31) / 32;
+    }
+    return 1;
+}
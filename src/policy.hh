@@ -0,0 +1,62 @@
+#pragma once
+#include "storage.hh"
+#include "types.hh"
+
+// Replacement policies over the state of one set. Free lines are always
+// filled first, so 'victim' is only asked about full sets; it must keep
+// choosing the same line until 'insert' is called (a dirty victim is chosen
+// once for the writeback and again for the fill).
+
+// Exact LRU as per-line recency ranks (any associativity)
+class RankedLru {
+    public:
+        static u32 victim(Set&);
+        static void touch(Set&, u32);
+        static void insert(Set&, u32);
+};
+
+// Exact LRU as a recency permutation packed in nibbles (up to 16 ways)
+class PackedLru {
+    public:
+        static u32 victim(Set&);
+        static void touch(Set&, u32);
+        static void insert(Set&, u32);
+};
+
+// Tree pseudo-LRU with one bit per internal node (power of two ways)
+class TreePlru {
+    public:
+        static u32 victim(Set&);
+        static void touch(Set&, u32);
+        static void insert(Set&, u32);
+};
+
+// Static re-reference interval prediction with 2-bit RRPVs
+class Srrip {
+    public:
+        static u32 victim(Set&);
+        static void touch(Set&, u32);
+        static void insert(Set&, u32);
+};
+
+// First in first out with a round robin pointer
+class Fifo {
+    public:
+        static u32 victim(Set&);
+        static void touch(Set&, u32);
+        static void insert(Set&, u32);
+};
+
+// Pseudo-random (hashed per set and fill count, so runs are repeatable)
+class Random {
+    public:
+        static u32 victim(Set&);
+        static void touch(Set&, u32);
+        static void insert(Set&, u32);
+};
+
+namespace policy {
+    bool is_supported(u8, u32);
+    bool is_ranked(u8, u32);
+    u32 get_words(u8, u32);
+}
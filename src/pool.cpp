@@ -0,0 +1,77 @@
+#include <exception>
+#include "pool.hh"
+#include "types.hh"
+
+Pool::Pool(u32 thread_count) {
+    // Zero selects one thread per core
+    if (thread_count == 0) {
+        thread_count = Thread::hardware_concurrency();
+    }
+    this->thread_count = thread_count > 0 ? thread_count : 1;
+    this->queues = Vector<Deque<u64>>(this->thread_count);
+    this->locks = Vector<Mutex>(this->thread_count);
+    this->error = nullptr;
+}
+
+u32 Pool::get_thread_count() {
+    return this->thread_count;
+}
+
+void Pool::run(u64 count, Function<void(u64)> job) {
+    // Deal the jobs out round robin
+    for (u64 i = 0; i < count; i++) {
+        this->queues[i % this->thread_count].push_back(i);
+    }
+
+    // The calling thread is the first worker
+    auto threads = Vector<Thread>();
+    for (u32 i = 1; i < this->thread_count; i++) {
+        threads.push_back(Thread(&Pool::work, this, i, std::ref(job)));
+    }
+    this->work(0, job);
+    for (auto &thread: threads) {
+        thread.join();
+    }
+
+    // Report the first failure
+    if (this->error != nullptr) {
+        auto error = this->error;
+        this->error = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+bool Pool::take(u32 worker, u64 &job) {
+    // Work from the back of the local queue and steal from the front of the
+    // others (jobs are never added while running so empty queues stay empty)
+    for (u32 i = 0; i < this->thread_count; i++) {
+        auto victim = (worker + i) % this->thread_count;
+        std::lock_guard<Mutex> guard(this->locks[victim]);
+        auto &queue = this->queues[victim];
+        if (!queue.empty()) {
+            if (i == 0) {
+                job = queue.back();
+                queue.pop_back();
+            } else {
+                job = queue.front();
+                queue.pop_front();
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+void Pool::work(u32 worker, Function<void(u64)> &job) {
+    u64 index = 0;
+    while (this->take(worker, index)) {
+        try {
+            job(index);
+        } catch (...) {
+            std::lock_guard<Mutex> guard(this->error_lock);
+            if (this->error == nullptr) {
+                this->error = std::current_exception();
+            }
+        }
+    }
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include <exception>
+#include "types.hh"
+
+class Pool {
+    private:
+        u32 thread_count;
+        Vector<Deque<u64>> queues;
+        Vector<Mutex> locks;
+        Mutex error_lock;
+        std::exception_ptr error;
+        bool take(u32, u64&);
+        void work(u32, Function<void(u64)>&);
+
+    public:
+        Pool(u32);
+        u32 get_thread_count();
+        void run(u64, Function<void(u64)>);
+};
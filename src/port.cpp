@@ -0,0 +1,53 @@
+#include "port.hh"
+#include "types.hh"
+#include "unit.hh"
+
+Port::Port(u32 shift) {
+    this->shift = shift;
+    this->sequence = 0;
+    this->line = 0;
+    this->stored = false;
+    this->touched = false;
+    this->requests = Vector<Request>();
+    this->touches = Vector<Request>();
+}
+
+u32 Port::read(Unit &unit, u64 addr) {
+    auto *port = unit.port;
+    port->requests.push_back(Request{port->sequence, addr, false});
+    return 0;
+}
+
+u32 Port::write(Unit &unit, u64 addr) {
+    auto *port = unit.port;
+    port->requests.push_back(Request{port->sequence, addr, true});
+    return 0;
+}
+
+void Port::begin(u64 sequence, u64 addr, bool store) {
+    // Start an access, noting its line unless the core just touched the line
+    // in the same way (nothing else can change its state within the epoch)
+    this->sequence = sequence;
+    auto line = addr >> this->shift;
+    if (this->touched && line == this->line && (this->stored || !store)) {
+        return;
+    }
+    this->touches.push_back(Request{sequence, line, store});
+    this->line = line;
+    this->stored = store;
+    this->touched = true;
+}
+
+void Port::clear() {
+    this->requests.clear();
+    this->touches.clear();
+    this->touched = false;
+}
+
+Vector<Request> &Port::get_requests() {
+    return this->requests;
+}
+
+Vector<Request> &Port::get_touches() {
+    return this->touches;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include "types.hh"
+
+class Unit;
+
+// An access that left a core's private levels (or a line the core touched),
+// tagged with the position in its epoch of the access that caused it
+struct Request {
+    u64 sequence;
+    u64 address;
+    bool store;
+};
+
+// Stands in for the shared levels below a core's private levels. During an
+// epoch the requests are only queued (taking no time); they are replayed on
+// the shared levels at the end of the epoch, in access order across the
+// cores, along with the lines the core touched for the directory.
+class Port {
+    private:
+        u32 shift;
+        u64 sequence;
+        u64 line;
+        bool stored;
+        bool touched;
+        Vector<Request> requests;
+        Vector<Request> touches;
+
+    public:
+        Port(u32);
+        static u32 read(Unit&, u64);
+        static u32 write(Unit&, u64);
+        void begin(u64, u64, bool);
+        void clear();
+        Vector<Request> &get_requests();
+        Vector<Request> &get_touches();
+};
@@ -0,0 +1,355 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "chars.hh"
+#include "consts.hh"
+#include "exceptions.hh"
+#include "inflater.hh"
+#include "reader.hh"
+#include "record.hh"
+#include "text.hh"
+#include "trace.hh"
+#include "types.hh"
+using namespace std;
+
+Reader::Reader(const String &path) {
+    this->path = path;
+    this->descriptor = -1;
+    this->map = NULL;
+    this->map_size = 0;
+    this->inflater = NULL;
+    this->buffer = Vector<char>();
+    this->cursor = NULL;
+    this->end = NULL;
+    this->eof = false;
+    this->line = 0;
+    this->binary = false;
+    this->header = trace::Header();
+    this->previous = 0;
+    this->core = 0;
+
+    // Open the file ('-' is standard input)
+    if (path.compare(text::STDIN) == 0) {
+        this->descriptor = STDIN_FILENO;
+    } else {
+        this->descriptor = open(path.c_str(), O_RDONLY);
+    }
+    if (this->descriptor < 0) {
+        auto sb = StringBuilder();
+        sb << "'" << path << "' could not be opened";
+        throw IoException(sb.str());
+    }
+
+    // Regular files are mapped in their entirety
+    struct stat info;
+    if (fstat(this->descriptor, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+        auto *map = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, this->descriptor, 0);
+        if (map != MAP_FAILED) {
+            madvise(map, info.st_size, MADV_SEQUENTIAL);
+            this->map = (char*)map;
+            this->map_size = info.st_size;
+            auto format = Inflater::detect(this->map, this->map_size);
+            if (format != consts::PLAIN) {
+                this->decompress(format, this->map, this->map_size, -1);
+                return;
+            }
+            this->cursor = this->map;
+            this->end = this->map + this->map_size;
+            this->eof = true;
+            this->detect();
+            return;
+        }
+    }
+
+    // Everything else is streamed in blocks
+    this->buffer.resize(consts::BLOCK_SIZE);
+    this->cursor = this->buffer.data();
+    this->end = this->buffer.data();
+    this->refill();
+    auto format = Inflater::detect(this->cursor, this->end - this->cursor);
+    if (format != consts::PLAIN) {
+        this->decompress(format, this->cursor, this->end - this->cursor, this->eof ? -1 : this->descriptor);
+        return;
+    }
+    this->detect();
+}
+
+Reader::~Reader() {
+    if (this->inflater != NULL) {
+        delete this->inflater;
+    }
+    if (this->map != NULL) {
+        munmap(this->map, this->map_size);
+    }
+    if (this->descriptor > STDIN_FILENO) {
+        close(this->descriptor);
+    }
+}
+
+void Reader::detect() {
+    // Binary traces start with a header, anything else is parsed as text
+    auto size = (u64)(this->end - this->cursor);
+    if (this->header.decode((const u8*)this->cursor, size)) {
+        auto version = this->header.version;
+        if (version < trace::VERSION_32 || version > trace::VERSION || this->header.chunk_records == 0) {
+            auto sb = StringBuilder();
+            sb << "unsupported trace version in '" << this->path << "'";
+            throw FormatException(sb.str());
+        }
+        this->binary = true;
+        this->cursor += trace::HEADER_SIZE;
+    }
+}
+
+void Reader::decompress(u8 format, const char *data, u64 size, int descriptor) {
+    // Compressed files are streamed in blocks from the inflater's thread
+    // (detecting the format of the decompressed bytes)
+    this->inflater = new Inflater(this->path, format, data, size, descriptor);
+    this->buffer.resize(consts::BLOCK_SIZE);
+    this->cursor = this->buffer.data();
+    this->end = this->buffer.data();
+    this->eof = false;
+    this->refill();
+    this->detect();
+}
+
+bool Reader::is_binary() {
+    return this->binary;
+}
+
+u64 Reader::read(Record *records, u64 count) {
+    if (this->binary) {
+        return this->read_trace(records, count);
+    }
+    return this->read_text(records, count);
+}
+
+void Reader::seek(u64 record) {
+    // Jump to the chunk holding the record through the chunk index (only
+    // mapped binary traces can seek)
+    if (!this->binary || this->map == NULL || this->inflater != NULL || this->header.index == 0) {
+        throw RuntimeException("seeking requires a mapped binary trace");
+    }
+    auto chunk = min(record, this->header.count) / this->header.chunk_records;
+    auto chunks = (this->header.count + this->header.chunk_records - 1) / this->header.chunk_records;
+    if (chunk == chunks) {
+        this->cursor = this->end;
+        this->line = this->header.count;
+        return;
+    }
+    auto entry = this->header.index + chunk * sizeof(u64);
+    if (entry + sizeof(u64) > this->map_size) {
+        this->fail("chunk index is truncated");
+    }
+    auto offset = trace::get_u64((const u8*)this->map + entry);
+    if (offset > this->map_size) {
+        this->fail("chunk index is truncated");
+    }
+    this->cursor = this->map + offset;
+    this->line = chunk * this->header.chunk_records;
+
+    // Decode up to the record within the chunk
+    Record skipped;
+    while (this->line < record && this->read_trace(&skipped, 1) == 1);
+}
+
+u64 Reader::read_trace(Record *records, u64 count) {
+    u64 n = 0;
+    auto total = this->header.count;
+    auto chunk = (u64)this->header.chunk_records;
+    while (n < count && this->line < total) {
+        // Keep a whole record in the buffer
+        if (!this->eof && (u64)(this->end - this->cursor) < trace::MAX_RECORD) {
+            this->refill();
+        }
+
+        // Every chunk restarts the delta chain (and the core)
+        if (this->line % chunk == 0) {
+            this->previous = 0;
+            this->core = 0;
+        }
+        this->line += 1;
+        u64 zigzag = 0;
+        bool store = false;
+        bool switched = false;
+        auto version = this->header.version;
+        auto *next = trace::get_record((const u8*)this->cursor, (const u8*)this->end, version, zigzag, store, switched);
+        if (next != NULL && switched) {
+            u64 core = 0;
+            next = trace::get_varint(next, (const u8*)this->end, core);
+            if (core > UINT16_MAX) {
+                this->fail("core is out of range");
+            }
+            this->core = (u16)core;
+        }
+        if (next == NULL) {
+            this->fail("trace is truncated");
+        }
+        this->previous = trace::decode(this->previous, zigzag);
+        if (this->header.version == trace::VERSION_32) {
+            this->previous = (u32)this->previous;
+        }
+        records[n].address = this->previous;
+        records[n].store = store;
+        records[n].core = this->core;
+        this->cursor = (const char*)next;
+        n += 1;
+    }
+    return n;
+}
+
+u64 Reader::read_text(Record *records, u64 count) {
+    u64 n = 0;
+    while (n < count) {
+        // Find the end of the current line
+        auto remaining = (u64)(this->end - this->cursor);
+        auto *lf = (const char*)memchr(this->cursor, chars::LF, remaining);
+        if (lf == NULL) {
+            if (!this->eof) {
+                // The line continues past the buffer
+                this->refill();
+                continue;
+            } else if (remaining == 0) {
+                break;
+            }
+            lf = this->end;
+        }
+
+        // Parse the line in place
+        this->line += 1;
+        if (this->parse(this->cursor, lf, records[n])) {
+            n += 1;
+        }
+        this->cursor = lf == this->end ? lf : lf + 1;
+    }
+    return n;
+}
+
+void Reader::refill() {
+    // Move the partial line to the front of the buffer (growing the buffer
+    // if the line fills it entirely)
+    auto remaining = (u64)(this->end - this->cursor);
+    memmove(this->buffer.data(), this->cursor, remaining);
+    if (remaining == this->buffer.size()) {
+        this->buffer.resize(this->buffer.size() * 2);
+    }
+
+    // Read as much as the buffer will hold
+    auto *data = this->buffer.data();
+    auto size = remaining;
+    while (size < this->buffer.size()) {
+        if (this->inflater != NULL) {
+            auto bytes = this->inflater->read(data + size, this->buffer.size() - size);
+            this->eof = bytes == 0;
+            size += bytes;
+            break;
+        }
+        auto bytes = ::read(this->descriptor, data + size, this->buffer.size() - size);
+        if (bytes < 0 && errno == EINTR) {
+            continue;
+        } else if (bytes < 0) {
+            auto sb = StringBuilder();
+            sb << "'" << this->path << "' could not be read";
+            throw IoException(sb.str());
+        } else if (bytes == 0) {
+            this->eof = true;
+            break;
+        }
+        size += bytes;
+    }
+    this->cursor = data;
+    this->end = data + size;
+}
+
+bool Reader::parse(const char *c, const char *end, Record &record) {
+    // Skip leading blanks (blank lines are ignored)
+    while (c < end && chars::is_blank(*c)) {
+        c++;
+    }
+    if (c == end) {
+        return false;
+    }
+
+    // Parse the instruction
+    if (end - c < 3 || !chars::is_blank(c[2])) {
+        this->fail("unrecognized instruction");
+    }
+    auto first = chars::normalize(c[0]);
+    auto second = chars::normalize(c[1]);
+    if (first == chars::UPPER_L && second == chars::UPPER_D) {
+        record.store = false;
+    } else if (first == chars::UPPER_S && second == chars::UPPER_T) {
+        record.store = true;
+    } else {
+        this->fail("unrecognized instruction");
+    }
+    c += 2;
+    while (c < end && chars::is_blank(*c)) {
+        c++;
+    }
+
+    // Parse the address (decimal or '0x' hexadecimal, up to 64 bits)
+    u64 address = 0;
+    auto *start = c;
+    if (end - c > 2 && c[0] == chars::NUM_0 && chars::normalize(c[1]) == chars::UPPER_X) {
+        c += 2;
+        start = c;
+        for (i8 digit; c < end && (digit = chars::hex_value(*c)) >= 0; c++) {
+            if (address >> 60) {
+                this->fail("'address' could not be parsed");
+            }
+            address = address << 4 | digit;
+        }
+    } else {
+        for (; c < end && chars::is_digit(*c); c++) {
+            u64 digit = *c - chars::NUM_0;
+            if (address > (UINT64_MAX - digit) / 10) {
+                this->fail("'address' could not be parsed");
+            }
+            address = address * 10 + digit;
+        }
+    }
+    if (c == start) {
+        this->fail("'address' could not be parsed");
+    }
+
+    // An optional core may follow the address (after a blank)
+    auto *blank = c;
+    while (c < end && chars::is_blank(*c)) {
+        c++;
+    }
+    u32 core = 0;
+    if (c != end && c != blank) {
+        start = c;
+        for (; c < end && chars::is_digit(*c); c++) {
+            core = core * 10 + (*c - chars::NUM_0);
+            if (core > UINT16_MAX) {
+                this->fail("'core' could not be parsed");
+            }
+        }
+        if (c == start) {
+            this->fail("'core' could not be parsed");
+        }
+        while (c < end && chars::is_blank(*c)) {
+            c++;
+        }
+    }
+
+    // Only trailing blanks may follow
+    if (c != end) {
+        this->fail("'address' could not be parsed");
+    }
+    record.address = address;
+    record.core = (u16)core;
+    return true;
+}
+
+void Reader::fail(const char *message) {
+    auto sb = StringBuilder();
+    sb << message << (this->binary ? " on record " : " on line ") << this->line << " in '" << this->path << "'";
+    throw FormatException(sb.str());
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include "inflater.hh"
+#include "record.hh"
+#include "source.hh"
+#include "trace.hh"
+#include "types.hh"
+
+class Reader: public Source {
+    private:
+        String path;
+        int descriptor;
+        char *map;
+        u64 map_size;
+        Inflater *inflater;
+        Vector<char> buffer;
+        const char *cursor;
+        const char *end;
+        bool eof;
+        u64 line;
+        bool binary;
+        trace::Header header;
+        u64 previous;
+        u16 core;
+        void detect();
+        void decompress(u8, const char*, u64, int);
+        void refill();
+        u64 read_text(Record*, u64);
+        u64 read_trace(Record*, u64);
+        bool parse(const char*, const char*, Record&);
+        void fail(const char*);
+
+    public:
+        Reader(const String&);
+        ~Reader();
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+        u64 read(Record*, u64);
+        void seek(u64);
+        bool is_binary();
+};
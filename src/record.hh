@@ -0,0 +1,9 @@
+#pragma once
+#include "types.hh"
+
+// A single decoded access (plain data so batches can be copied in bulk)
+struct Record {
+    u64 address;
+    bool store;
+    u16 core;
+};
@@ -0,0 +1,81 @@
+#pragma once
+#include "consts.hh"
+#include "types.hh"
+
+// A batch of decoded accesses (or decompressed bytes)
+template <typename T>
+struct Batch {
+    Vector<T> items;
+    u64 count;
+};
+
+// Single producer, single consumer ring of preallocated batches. The producer
+// fills the batch at the head and publishes it, the consumer drains the batch
+// at the tail and releases it. Either side yields while the ring is full or
+// empty, which is what applies back-pressure to the reader.
+template <typename T>
+class Ring {
+    private:
+        // The counters are padded apart rather than aligned, so rings may be
+        // allocated on the heap
+        Vector<Batch<T>> slots;
+        char head_padding[consts::CACHE_LINE];
+        Atomic<u64> head;
+        char tail_padding[consts::CACHE_LINE];
+        Atomic<u64> tail;
+        char closed_padding[consts::CACHE_LINE];
+        Atomic<bool> closed;
+
+    public:
+        Ring(u64 slots, u64 batch_size) {
+            this->slots = Vector<Batch<T>>(slots);
+            for (auto &slot: this->slots) {
+                slot.items = Vector<T>(batch_size);
+                slot.count = 0;
+            }
+            this->head.store(0);
+            this->tail.store(0);
+            this->closed.store(false);
+        }
+
+        Ring(const Ring&) = delete;
+        Ring& operator=(const Ring&) = delete;
+
+        Batch<T> &acquire() {
+            // Wait for the consumer to release a slot (only the producer moves head)
+            auto head = this->head.load(std::memory_order_relaxed);
+            while (head - this->tail.load(std::memory_order_acquire) == this->slots.size()) {
+                std::this_thread::yield();
+            }
+            return this->slots[head % this->slots.size()];
+        }
+
+        void publish() {
+            this->head.store(this->head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+
+        void close() {
+            this->closed.store(true, std::memory_order_release);
+        }
+
+        Batch<T> *front() {
+            // Wait for the producer to publish a batch, returns NULL once the
+            // ring is closed and drained (only the consumer moves tail)
+            auto tail = this->tail.load(std::memory_order_relaxed);
+            while (this->head.load(std::memory_order_acquire) == tail) {
+                if (this->closed.load(std::memory_order_acquire)) {
+                    // Batches published before closing are still drained
+                    if (this->head.load(std::memory_order_acquire) == tail) {
+                        return NULL;
+                    }
+                    break;
+                }
+                std::this_thread::yield();
+            }
+            return &this->slots[tail % this->slots.size()];
+        }
+
+        void release() {
+            this->tail.store(this->tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+        }
+};
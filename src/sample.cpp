@@ -0,0 +1,123 @@
+#include <cmath>
+#include "chars.hh"
+#include "consts.hh"
+#include "sample.hh"
+#include "types.hh"
+
+Sample::Sample(u32 rate, u32 set_count) {
+    this->rate = rate;
+    this->set_count = set_count;
+    this->sampled_sets = 0;
+    this->access_count = 0;
+    this->miss_count = 0;
+    this->skip_count = 0;
+    this->tallies = HashMap<u32, Tally>();
+
+    // Count the sets that made it into the sample
+    for (u32 set = 0; set < set_count; set++) {
+        if (this->is_sampled(set)) {
+            this->sampled_sets += 1;
+        }
+    }
+}
+
+bool Sample::is_sampled(u32 set) {
+    // Roughly one set in 'rate', spread by a multiplicative hash so strided
+    // set patterns don't line up with the sample
+    return (u32)((set * consts::GOLDEN) >> 32) % this->rate == 0;
+}
+
+void Sample::record(u32 set, u32 misses) {
+    auto &tally = this->tallies[set];
+    tally.accesses += 1;
+    tally.misses += misses;
+    this->access_count += 1;
+    this->miss_count += misses;
+}
+
+void Sample::skip() {
+    this->skip_count += 1;
+}
+
+u32 Sample::get_rate() {
+    return this->rate;
+}
+
+u32 Sample::get_set_count() {
+    return this->set_count;
+}
+
+u32 Sample::get_sampled_sets() {
+    return this->sampled_sets;
+}
+
+u64 Sample::get_access_count() {
+    return this->access_count;
+}
+
+u64 Sample::get_skip_count() {
+    return this->skip_count;
+}
+
+f64 Sample::get_scale() {
+    // Every access is seen (sampled or skipped), so the counters scale by
+    // the share of accesses that were simulated
+    if (this->access_count == 0) {
+        return 1.0;
+    }
+    return (f64)(this->access_count + this->skip_count) / this->access_count;
+}
+
+f64 Sample::get_miss_ratio() {
+    if (this->access_count == 0) {
+        return 0.0;
+    }
+    return (f64)this->miss_count / this->access_count;
+}
+
+f64 Sample::get_margin() {
+    // Half width of the confidence interval of the miss ratio, treating the
+    // sampled sets as clusters (ratio estimator with a finite population
+    // correction; untouched sets count as empty clusters)
+    auto n = (f64)this->sampled_sets;
+    if (this->sampled_sets < 2 || this->access_count == 0) {
+        return 0.0;
+    }
+    auto ratio = this->get_miss_ratio();
+    f64 sum = 0.0;
+    for (auto &entry: this->tallies) {
+        auto residual = entry.second.misses - ratio * entry.second.accesses;
+        sum += residual * residual;
+    }
+    auto mean = this->access_count / n;
+    auto correction = 1.0 - n / this->set_count;
+    auto variance = correction * sum / (n - 1) / (n * mean * mean);
+    return consts::CONFIDENCE * sqrt(variance);
+}
+
+u32 sample::parse_rate(const String &value) {
+    // Parses '1/N' or 'N' (one set in N), returns zero if it is malformed
+    auto digits = value;
+    auto slash = value.find(chars::SLASH);
+    if (slash != String::npos) {
+        if (slash != 1 || value[0] != chars::NUM_1) {
+            return 0;
+        }
+        digits = value.substr(slash + 1);
+    }
+    u64 rate = 0;
+    for (auto c: digits) {
+        if (!chars::is_digit(c) || rate > UINT32_MAX / 10) {
+            return 0;
+        }
+        rate = rate * 10 + (c - chars::NUM_0);
+    }
+    return rate <= UINT32_MAX ? (u32)rate : 0;
+}
+
+void Sample::reset() {
+    this->access_count = 0;
+    this->miss_count = 0;
+    this->skip_count = 0;
+    this->tallies.clear();
+}
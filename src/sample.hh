@@ -0,0 +1,38 @@
+#pragma once
+#include "types.hh"
+
+// Per set access and miss counts of a sampled set
+struct Tally {
+    u64 accesses;
+    u64 misses;
+};
+
+class Sample {
+    private:
+        u32 rate;
+        u32 set_count;
+        u32 sampled_sets;
+        u64 access_count;
+        u64 miss_count;
+        u64 skip_count;
+        HashMap<u32, Tally> tallies;
+
+    public:
+        Sample(u32, u32);
+        void reset();
+        bool is_sampled(u32);
+        void record(u32, u32);
+        void skip();
+        u32 get_rate();
+        u32 get_set_count();
+        u32 get_sampled_sets();
+        u64 get_access_count();
+        u64 get_skip_count();
+        f64 get_scale();
+        f64 get_miss_ratio();
+        f64 get_margin();
+};
+
+namespace sample {
+    u32 parse_rate(const String&);
+}
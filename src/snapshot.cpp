@@ -0,0 +1,70 @@
+#include <cstring>
+#include "exceptions.hh"
+#include "snapshot.hh"
+#include "types.hh"
+
+SnapshotWriter::SnapshotWriter(const String &path) {
+    this->path = path;
+    this->file = FileWriter(path, FileWriter::binary | FileWriter::trunc);
+    if (!this->file) {
+        auto sb = StringBuilder();
+        sb << "'" << path << "' could not be opened";
+        throw IoException(sb.str());
+    }
+    this->file.write((const char*)snapshot::MAGIC, sizeof(snapshot::MAGIC));
+    this->file.write((const char*)&snapshot::VERSION, sizeof(snapshot::VERSION));
+}
+
+void SnapshotWriter::put(u64 value) {
+    this->file.write((const char*)&value, sizeof(value));
+}
+
+void SnapshotWriter::close() {
+    this->file.close();
+    if (!this->file) {
+        auto sb = StringBuilder();
+        sb << "'" << this->path << "' could not be written";
+        throw IoException(sb.str());
+    }
+}
+
+SnapshotReader::SnapshotReader(const String &path) {
+    this->path = path;
+    this->file = FileReader(path, FileReader::binary);
+    if (!this->file) {
+        auto sb = StringBuilder();
+        sb << "'" << path << "' could not be opened";
+        throw IoException(sb.str());
+    }
+    u8 magic[sizeof(snapshot::MAGIC)];
+    u32 version = 0;
+    this->file.read((char*)magic, sizeof(magic));
+    this->file.read((char*)&version, sizeof(version));
+    if (!this->file || memcmp(magic, snapshot::MAGIC, sizeof(magic)) != 0) {
+        this->fail("is not a snapshot");
+    } else if (version != snapshot::VERSION) {
+        this->fail("has an unsupported version");
+    }
+}
+
+u64 SnapshotReader::get() {
+    u64 value = 0;
+    this->file.read((char*)&value, sizeof(value));
+    if (!this->file) {
+        this->fail("is truncated");
+    }
+    return value;
+}
+
+void SnapshotReader::expect(u64 value) {
+    // Configuration values must match the hierarchy being restored
+    if (this->get() != value) {
+        this->fail("does not match the configuration");
+    }
+}
+
+void SnapshotReader::fail(const char *message) {
+    auto sb = StringBuilder();
+    sb << "'" << this->path << "' " << message;
+    throw FormatException(sb.str());
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include "types.hh"
+
+namespace snapshot {
+    // Snapshot layout (integers and line arrays in host byte order):
+    //   [0, 8)   magic
+    //   [8, 12)  version
+    // followed by every level from the top: its configuration (which must
+    // match on restore), its counters and its lines. Arrays are stored as a
+    // u64 element count followed by the raw elements.
+    const u8 MAGIC[] = {'C', 'S', 'I', 'M', 'S', 'N', 'A', 'P'};
+    const u32 VERSION = 2;
+}
+
+class SnapshotWriter {
+    private:
+        String path;
+        FileWriter file;
+
+    public:
+        SnapshotWriter(const String&);
+        void put(u64);
+        template <typename T> void put(const Vector<T>&);
+        void close();
+};
+
+class SnapshotReader {
+    private:
+        String path;
+        FileReader file;
+
+    public:
+        SnapshotReader(const String&);
+        u64 get();
+        template <typename T> void get(Vector<T>&, u64);
+        template <typename T> void get(Vector<T>&);
+        void expect(u64);
+        void fail(const char*);
+};
+
+template <typename T>
+void SnapshotWriter::put(const Vector<T> &vec) {
+    this->put(vec.size());
+    this->file.write((const char*)vec.data(), vec.size() * sizeof(T));
+}
+
+template <typename T>
+void SnapshotReader::get(Vector<T> &vec, u64 limit) {
+    // At most 'limit' elements, so a damaged count can't exhaust memory
+    auto size = this->get();
+    if (size > limit) {
+        this->fail("has a damaged array");
+    }
+    vec.resize(size);
+    this->file.read((char*)vec.data(), size * sizeof(T));
+    if (!this->file) {
+        this->fail("is truncated");
+    }
+}
+
+template <typename T>
+void SnapshotReader::get(Vector<T> &vec) {
+    // Exactly as many elements as the array already holds
+    auto size = vec.size();
+    this->get(vec, size);
+    if (vec.size() != size) {
+        this->fail("does not match the configuration");
+    }
+}
@@ -0,0 +1,10 @@
+#pragma once
+#include "record.hh"
+#include "types.hh"
+
+// Anything that yields batches of accesses (access files and generators)
+class Source {
+    public:
+        virtual ~Source() {}
+        virtual u64 read(Record*, u64) = 0;
+};
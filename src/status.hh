@@ -5,4 +5,7 @@ namespace status {
     const int USAGE = 0x01;
     const int CONF = 0x02;
     const int ACCESS = 0x03;
+    const int CONVERT = 0x04;
+    const int GEN = 0x05;
+    const int SNAPSHOT = 0x06;
 }
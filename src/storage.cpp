@@ -0,0 +1,226 @@
+#include <algorithm>
+#include "consts.hh"
+#include "match.hh"
+#include "snapshot.hh"
+#include "storage.hh"
+#include "types.hh"
+using namespace std;
+
+Set::Set(u32 way, u32 index, u64 *lines, u32 *ages, u64 *state) {
+    this->way = way;
+    this->index = index;
+    this->lines = lines;
+    this->ages = ages;
+    this->state = state;
+}
+
+u32 Set::find(u64 tag) {
+    // Returns the way holding the tag or 'way' if it is not present (the
+    // dirty bit is ignored)
+    auto line = tag << consts::LINE_BITS | consts::LINE_VALID | consts::LINE_DIRTY;
+    if (this->way >= consts::MATCH_WAY) {
+        return this->search(line, consts::LINE_DIRTY);
+    }
+    for (u32 i = 0; i < this->way; i++) {
+        if ((this->lines[i] | consts::LINE_DIRTY) == line) {
+            return i;
+        }
+    }
+    return this->way;
+}
+
+u32 Set::free() {
+    // Returns the first invalid way or 'way' if the set is full
+    if (this->way >= consts::MATCH_WAY) {
+        return this->search(~(u64)consts::LINE_VALID, ~(u64)consts::LINE_VALID);
+    }
+    for (u32 i = 0; i < this->way; i++) {
+        if (!(this->lines[i] & consts::LINE_VALID)) {
+            return i;
+        }
+    }
+    return this->way;
+}
+
+u32 Set::search(u64 value, u64 mask) {
+    // Large sets are compared a block at a time, the lowest matching way wins
+    for (u32 base = 0; base < this->way; base += consts::MATCH_WIDTH) {
+        auto bits = match::lines(this->lines + base, min(this->way - base, consts::MATCH_WIDTH), value, mask);
+        if (bits != 0) {
+            return base + __builtin_ctzll(bits);
+        }
+    }
+    return this->way;
+}
+
+void Set::fill(u32 index, u64 tag) {
+    // The replacement policy is updated separately
+    this->lines[index] = tag << consts::LINE_BITS | consts::LINE_VALID;
+}
+
+void Set::clear(u32 index) {
+    // The way is found by 'free' again (the replacement state is left as is)
+    this->lines[index] = 0;
+}
+
+u32 Set::get_way() {
+    return this->way;
+}
+
+u32 Set::get_index() {
+    return this->index;
+}
+
+u32 *Set::get_ages() {
+    return this->ages;
+}
+
+u64 *Set::get_state() {
+    return this->state;
+}
+
+u64 *Set::get_line(u32 index) {
+    return &this->lines[index];
+}
+
+u64 Set::get_tag(u32 index) {
+    return this->lines[index] >> consts::LINE_BITS;
+}
+
+bool Set::get_valid(u32 index) {
+    return (this->lines[index] & consts::LINE_VALID) != 0;
+}
+
+bool Set::get_dirty(u32 index) {
+    return (this->lines[index] & consts::LINE_DIRTY) != 0;
+}
+
+void Set::set_dirty(u32 index, bool dirty) {
+    if (dirty) {
+        this->lines[index] |= consts::LINE_DIRTY;
+    } else {
+        this->lines[index] &= ~(u64)consts::LINE_DIRTY;
+    }
+}
+
+Chunk::Chunk() {
+    this->lines = Vector<u64>();
+    this->ages = Vector<u32>();
+    this->states = Vector<u64>();
+}
+
+bool Chunk::is_allocated() {
+    return !this->lines.empty();
+}
+
+void Chunk::allocate(u32 set_count, u32 way, u32 words, bool ranked) {
+    // Ranked policies age every line (invalid lines are aged 'way'), the
+    // others pack their state into 'words' words per set
+    auto lines = (u64)set_count * way;
+    this->lines.assign(lines, 0);
+    this->ages.assign(ranked ? lines : 0, way);
+    this->states.assign((u64)set_count * words, 0);
+}
+
+Set Chunk::get(u32 set, u32 index, u32 way, u32 words) {
+    auto base = (u64)set * way;
+    return Set(
+        way,
+        index,
+        &this->lines[base],
+        this->ages.data() + (this->ages.empty() ? 0 : base),
+        this->states.data() + (u64)set * words
+    );
+}
+
+void Chunk::save(SnapshotWriter &writer) {
+    // Untouched chunks are only a flag
+    writer.put(this->is_allocated());
+    if (this->is_allocated()) {
+        writer.put(this->lines);
+        writer.put(this->ages);
+        writer.put(this->states);
+    }
+}
+
+void Chunk::restore(SnapshotReader &reader, u32 set_count, u32 way, u32 words, bool ranked) {
+    if (reader.get()) {
+        this->allocate(set_count, way, words, ranked);
+        reader.get(this->lines);
+        reader.get(this->ages);
+        reader.get(this->states);
+    }
+}
+
+Storage::Storage() {
+    this->set_count = 0;
+    this->way = 0;
+    this->words = 0;
+    this->ranked = false;
+    this->chunk_sets = 0;
+    this->chunk_shift = 0;
+    this->chunks = Shared<Vector<Chunk>>(new Vector<Chunk>());
+}
+
+void Storage::allocate(u32 set_count, u32 way, u32 words, bool ranked, bool lazy) {
+    this->set_count = set_count;
+    this->way = way;
+    this->words = words;
+    this->ranked = ranked;
+
+    // Split the sets into chunks of roughly 'CHUNK_LINES' lines each (a
+    // single chunk if the storage is allocated up front)
+    this->chunk_shift = 0;
+    if (lazy) {
+        while (
+            (1ULL << this->chunk_shift) < set_count &&
+            ((u64)way << this->chunk_shift) < consts::CHUNK_LINES
+        ) {
+            this->chunk_shift += 1;
+        }
+    } else {
+        while ((1ULL << this->chunk_shift) < set_count) {
+            this->chunk_shift += 1;
+        }
+    }
+    this->chunk_sets = 1 << this->chunk_shift;
+    auto count = (set_count + this->chunk_sets - 1) >> this->chunk_shift;
+    this->chunks = Shared<Vector<Chunk>>(new Vector<Chunk>(count));
+
+    // Small caches are allocated immediately
+    if (!lazy) {
+        this->reserve();
+    }
+}
+
+void Storage::reserve() {
+    // Allocates every chunk that hasn't been touched yet
+    for (auto &chunk: *this->chunks) {
+        if (!chunk.is_allocated()) {
+            chunk.allocate(this->chunk_sets, this->way, this->words, this->ranked);
+        }
+    }
+}
+
+Set Storage::get(u32 set) {
+    // Chunks are allocated on first touch
+    auto &chunk = (*this->chunks)[set >> this->chunk_shift];
+    if (!chunk.is_allocated()) {
+        chunk.allocate(this->chunk_sets, this->way, this->words, this->ranked);
+    }
+    return chunk.get(set & (this->chunk_sets - 1), set, this->way, this->words);
+}
+
+void Storage::save(SnapshotWriter &writer) {
+    writer.put(this->chunks->size());
+    for (auto &chunk: *this->chunks) {
+        chunk.save(writer);
+    }
+}
+
+void Storage::restore(SnapshotReader &reader) {
+    reader.expect(this->chunks->size());
+    for (auto &chunk: *this->chunks) {
+        chunk.restore(reader, this->chunk_sets, this->way, this->words, this->ranked);
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include "snapshot.hh"
+#include "types.hh"
+
+// Every line is one word: the tag above the valid and dirty bits (the address
+// is rebuilt from the tag and the set index)
+class Set {
+    private:
+        u32 way;
+        u32 index;
+        u64 *lines;
+        u32 *ages;
+        u64 *state;
+        u32 search(u64, u64);
+
+    public:
+        Set(u32, u32, u64*, u32*, u64*);
+        u32 find(u64);
+        u32 free();
+        void fill(u32, u64);
+        void clear(u32);
+        u32 get_way();
+        u32 get_index();
+        u32 *get_ages();
+        u64 *get_state();
+        u64 *get_line(u32);
+        u64 get_tag(u32);
+        bool get_valid(u32);
+        bool get_dirty(u32);
+        void set_dirty(u32, bool);
+};
+
+class Chunk {
+    private:
+        Vector<u64> lines;
+        Vector<u32> ages;
+        Vector<u64> states;
+
+    public:
+        Chunk();
+        bool is_allocated();
+        void allocate(u32, u32, u32, bool);
+        Set get(u32, u32, u32, u32);
+        void save(SnapshotWriter&);
+        void restore(SnapshotReader&, u32, u32, u32, bool);
+};
+
+// Copies share the same lines
+class Storage {
+    private:
+        u32 set_count;
+        u32 way;
+        u32 words;
+        bool ranked;
+        u32 chunk_sets;
+        u32 chunk_shift;
+        Shared<Vector<Chunk>> chunks;
+
+    public:
+        Storage();
+        void allocate(u32, u32, u32, bool, bool);
+        void reserve();
+        Set get(u32);
+        void save(SnapshotWriter&);
+        void restore(SnapshotReader&);
+};
@@ -0,0 +1,110 @@
+#include <cmath>
+#include <iostream>
+#include "config.hh"
+#include "consts.hh"
+#include "exceptions.hh"
+#include "memory.hh"
+#include "pool.hh"
+#include "reader.hh"
+#include "record.hh"
+#include "source.hh"
+#include "sweep.hh"
+#include "types.hh"
+#include "unit.hh"
+using namespace std;
+
+Sweep::Sweep(Config &config) {
+    this->config = &config;
+    this->memories = Vector<Memory*>();
+    this->indices = Vector<u64>();
+    this->trace = Vector<Record>();
+
+    // Build every configuration (skipping geometries without a single set)
+    for (u64 i = 0; i < config.size(); i++) {
+        auto *memory = new Memory();
+        try {
+            memory->conf(config, i);
+            if (memory->get_core_count() > 0) {
+                throw FormatException("multi-core hierarchies can't be swept");
+            }
+        } catch (...) {
+            delete memory;
+            throw;
+        }
+        if (memory->is_feasible()) {
+            this->memories.push_back(memory);
+            this->indices.push_back(i);
+        } else {
+            delete memory;
+        }
+    }
+}
+
+Sweep::~Sweep() {
+    for (auto *memory: this->memories) {
+        delete memory;
+    }
+}
+
+void Sweep::access(String &path) {
+    // Decode the access file once
+    Reader reader(path);
+    this->access(reader);
+}
+
+void Sweep::access(Source &source) {
+    auto records = Vector<Record>(consts::BATCH_SIZE);
+    while (auto count = source.read(records.data(), records.size())) {
+        this->trace.insert(this->trace.end(), records.begin(), records.begin() + count);
+    }
+
+    // Replay the shared trace through every hierarchy in parallel
+    Pool pool(0);
+    pool.run(
+        this->memories.size(),
+        [this](u64 i) {
+            this->memories[i]->exec(this->trace.data(), this->trace.size());
+        }
+    );
+}
+
+void Sweep::set_warmup(u64 warmup) {
+    for (auto *memory: this->memories) {
+        memory->set_warmup(warmup);
+    }
+}
+
+void Sweep::score() {
+    // One tab separated row per configuration
+    cout << "Config";
+    for (auto &column: this->config->header()) {
+        cout << "\t" << column;
+    }
+    if (!this->memories.empty()) {
+        for (auto *unit = this->memories[0]->get_unit(); unit != NULL; unit = unit->get_next()) {
+            auto label = unit->get_label();
+            cout << "\t" << label << ".HitCount"
+                << "\t" << label << ".MissCount"
+                << "\t" << label << ".AccessCount"
+                << "\t" << label << ".AccessTime";
+        }
+    }
+    cout << "\n";
+    for (u64 i = 0; i < this->memories.size(); i++) {
+        cout << this->indices[i];
+        for (auto &value: this->config->describe(this->indices[i])) {
+            cout << "\t" << value;
+        }
+        f64 scale = 1.0;
+        for (auto *unit = this->memories[i]->get_unit(); unit != NULL; unit = unit->get_next()) {
+            // Sampled levels and the levels below them report estimates
+            scale *= unit->get_scale();
+            cout << "\t" << llround(unit->get_hit_count() * scale)
+                << "\t" << llround(unit->get_miss_count() * scale)
+                << "\t" << llround((unit->get_hit_count() + unit->get_miss_count()) * scale)
+                << "\t" << llround(unit->get_access_time() * scale);
+        }
+        cout << "\n";
+    }
+    cout.flush();
+}
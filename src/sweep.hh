@@ -0,0 +1,24 @@
+#pragma once
+#include "config.hh"
+#include "memory.hh"
+#include "record.hh"
+#include "source.hh"
+#include "types.hh"
+
+class Sweep {
+    private:
+        Config *config;
+        Vector<Memory*> memories;
+        Vector<u64> indices;
+        Vector<Record> trace;
+
+    public:
+        Sweep(Config&);
+        ~Sweep();
+        Sweep(const Sweep&) = delete;
+        Sweep& operator=(const Sweep&) = delete;
+        void access(String&);
+        void access(Source&);
+        void set_warmup(u64);
+        void score();
+};
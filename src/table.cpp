@@ -0,0 +1,224 @@
+#include <algorithm>
+#include "consts.hh"
+#include "snapshot.hh"
+#include "table.hh"
+#include "types.hh"
+
+Table::Table() {
+    this->way = 0;
+    this->head = consts::NO_SLOT;
+    this->tail = consts::NO_SLOT;
+    this->bucket_shift = 0;
+    this->lines = Vector<u64>();
+    this->prev = Vector<u32>();
+    this->next = Vector<u32>();
+    this->buckets = Vector<u32>();
+}
+
+void Table::allocate(u32 way, bool lazy) {
+    // Large tables grow as lines are filled, the rest are sized up front
+    this->way = way;
+    this->head = consts::NO_SLOT;
+    this->tail = consts::NO_SLOT;
+    this->lines.clear();
+    this->prev.clear();
+    this->next.clear();
+    if (!lazy) {
+        this->lines.reserve(way);
+        this->prev.reserve(way);
+        this->next.reserve(way);
+    }
+    this->rehash(lazy ? consts::TABLE_BUCKETS : way);
+}
+
+void Table::rehash(u32 lines) {
+    // Keep the load factor at or below one half
+    u32 bits = 1;
+    while ((1ULL << bits) < 2ULL * lines) {
+        bits += 1;
+    }
+    this->bucket_shift = 64 - bits;
+    this->buckets.assign(1ULL << bits, consts::NO_SLOT);
+    for (u32 slot = 0; slot < this->lines.size(); slot++) {
+        this->index(slot);
+    }
+}
+
+u32 Table::home(u64 tag) {
+    return (u32)((tag * consts::GOLDEN) >> this->bucket_shift);
+}
+
+void Table::index(u32 slot) {
+    auto mask = (u32)this->buckets.size() - 1;
+    auto i = this->home(this->lines[slot] >> consts::LINE_BITS);
+    while (this->buckets[i] != consts::NO_SLOT) {
+        i = (i + 1) & mask;
+    }
+    this->buckets[i] = slot;
+}
+
+void Table::unindex(u32 slot) {
+    // Find the bucket, then shift the rest of the probe run back over it
+    auto mask = (u32)this->buckets.size() - 1;
+    auto i = this->home(this->lines[slot] >> consts::LINE_BITS);
+    while (this->buckets[i] != slot) {
+        i = (i + 1) & mask;
+    }
+    for (auto j = (i + 1) & mask; this->buckets[j] != consts::NO_SLOT; j = (j + 1) & mask) {
+        auto k = this->home(this->lines[this->buckets[j]] >> consts::LINE_BITS);
+        if (((j - k) & mask) >= ((j - i) & mask)) {
+            this->buckets[i] = this->buckets[j];
+            i = j;
+        }
+    }
+    this->buckets[i] = consts::NO_SLOT;
+}
+
+void Table::unlink(u32 slot) {
+    auto prev = this->prev[slot];
+    auto next = this->next[slot];
+    if (prev != consts::NO_SLOT) {
+        this->next[prev] = next;
+    } else {
+        this->head = next;
+    }
+    if (next != consts::NO_SLOT) {
+        this->prev[next] = prev;
+    } else {
+        this->tail = prev;
+    }
+}
+
+void Table::link(u32 slot) {
+    this->prev[slot] = consts::NO_SLOT;
+    this->next[slot] = this->head;
+    if (this->head != consts::NO_SLOT) {
+        this->prev[this->head] = slot;
+    } else {
+        this->tail = slot;
+    }
+    this->head = slot;
+}
+
+u32 Table::find(u64 tag) {
+    // Returns the slot holding the tag or 'NO_SLOT' if it is not present
+    auto mask = (u32)this->buckets.size() - 1;
+    for (auto i = this->home(tag); this->buckets[i] != consts::NO_SLOT; i = (i + 1) & mask) {
+        if (this->lines[this->buckets[i]] >> consts::LINE_BITS == tag) {
+            return this->buckets[i];
+        }
+    }
+    return consts::NO_SLOT;
+}
+
+u32 Table::insert(u64 tag) {
+    // Takes a new slot while there is room, otherwise replaces the least
+    // recently used line (the caller writes it back first if it is dirty)
+    u32 slot;
+    if (!this->is_full()) {
+        slot = this->lines.size();
+        this->lines.push_back(tag << consts::LINE_BITS | consts::LINE_VALID);
+        this->prev.push_back(consts::NO_SLOT);
+        this->next.push_back(consts::NO_SLOT);
+        if (2ULL * this->lines.size() > this->buckets.size()) {
+            this->rehash(this->lines.size());
+        } else {
+            this->index(slot);
+        }
+    } else {
+        slot = this->tail;
+        this->unindex(slot);
+        this->unlink(slot);
+        this->lines[slot] = tag << consts::LINE_BITS | consts::LINE_VALID;
+        this->index(slot);
+    }
+    this->link(slot);
+    return slot;
+}
+
+void Table::promote(u32 slot) {
+    // Move the slot to the front of the LRU list
+    if (this->head != slot) {
+        this->unlink(slot);
+        this->link(slot);
+    }
+}
+
+void Table::remove(u32 slot) {
+    // Move the last slot into the hole so the slots stay dense
+    this->unindex(slot);
+    this->unlink(slot);
+    auto last = (u32)this->lines.size() - 1;
+    if (slot != last) {
+        this->unindex(last);
+        auto prev = this->prev[last];
+        auto next = this->next[last];
+        this->lines[slot] = this->lines[last];
+        this->prev[slot] = prev;
+        this->next[slot] = next;
+        if (prev != consts::NO_SLOT) {
+            this->next[prev] = slot;
+        } else {
+            this->head = slot;
+        }
+        if (next != consts::NO_SLOT) {
+            this->prev[next] = slot;
+        } else {
+            this->tail = slot;
+        }
+        this->index(slot);
+    }
+    this->lines.pop_back();
+    this->prev.pop_back();
+    this->next.pop_back();
+}
+
+bool Table::is_full() {
+    return this->lines.size() == this->way;
+}
+
+u32 Table::get_last() {
+    return this->tail;
+}
+
+u64 Table::get_tag(u32 slot) {
+    return this->lines[slot] >> consts::LINE_BITS;
+}
+
+bool Table::get_dirty(u32 slot) {
+    return (this->lines[slot] & consts::LINE_DIRTY) != 0;
+}
+
+void Table::set_dirty(u32 slot, bool dirty) {
+    if (dirty) {
+        this->lines[slot] |= consts::LINE_DIRTY;
+    } else {
+        this->lines[slot] &= ~(u64)consts::LINE_DIRTY;
+    }
+}
+
+void Table::save(SnapshotWriter &writer) {
+    // The buckets are rebuilt on restore
+    writer.put(this->head);
+    writer.put(this->tail);
+    writer.put(this->lines);
+    writer.put(this->prev);
+    writer.put(this->next);
+}
+
+void Table::restore(SnapshotReader &reader) {
+    this->head = (u32)reader.get();
+    this->tail = (u32)reader.get();
+    reader.get(this->lines, this->way);
+    reader.get(this->prev, this->way);
+    reader.get(this->next, this->way);
+    auto lines = this->lines.size();
+    if (
+        this->prev.size() != lines || this->next.size() != lines ||
+        (this->head >= lines && this->head != consts::NO_SLOT) ||
+        (this->tail >= lines && this->tail != consts::NO_SLOT)
+    ) {
+        reader.fail("has a damaged table");
+    }
+    this->rehash(std::max((u32)lines, (u32)(this->buckets.size() / 2)));
+}
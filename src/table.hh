@@ -0,0 +1,39 @@
+#pragma once
+#include "snapshot.hh"
+#include "types.hh"
+
+// Fully associative storage: a slot array threaded by an LRU list (head is the
+// most recently used) and indexed by an open addressing tag hash (every slot
+// is one word, the tag above the valid and dirty bits, like set lines)
+class Table {
+    private:
+        u32 way;
+        u32 head;
+        u32 tail;
+        u32 bucket_shift;
+        Vector<u64> lines;
+        Vector<u32> prev;
+        Vector<u32> next;
+        Vector<u32> buckets;
+        u32 home(u64);
+        void index(u32);
+        void unindex(u32);
+        void unlink(u32);
+        void link(u32);
+        void rehash(u32);
+
+    public:
+        Table();
+        void allocate(u32, bool);
+        u32 find(u64);
+        u32 insert(u64);
+        void promote(u32);
+        void remove(u32);
+        bool is_full();
+        u32 get_last();
+        u64 get_tag(u32);
+        bool get_dirty(u32);
+        void set_dirty(u32, bool);
+        void save(SnapshotWriter&);
+        void restore(SnapshotReader&);
+};
@@ -11,6 +11,10 @@ namespace text {
     const String HIT_TIME = "HITTIME";
     const String WRITE_POLICY = "WRITEPOLICY";
     const String ALLOC_POLICY = "ALLOCATIONPOLICY";
+    const String REPLACEMENT = "REPLACEMENT";
+    const String SAMPLE = "SAMPLE";
+    const String CORES = "CORES";
+    const String COHERENCE = "COHERENCE";
 
     // Known configuration values
     const String MAIN = "MAIN";
@@ -18,8 +22,54 @@ namespace text {
     const String WRITE_THROUGH = "WRITETHROUGH";
     const String WRITE_ALLOCATE_ON = "WRITEALLOCATE";
     const String WRITE_ALLOCATE_OFF = "NOWRITEALLOCATE";
+    const String LRU = "LRU";
+    const String TREE_PLRU = "PLRU";
+    const String SRRIP = "SRRIP";
+    const String FIFO = "FIFO";
+    const String RANDOM = "RANDOM";
+    const String MSI = "MSI";
+    const String MESI = "MESI";
+
+    // Sweep syntax
+    const String RANGE = "..";
 
     // Known instructions
     const String LOAD = "LD";
     const String STORE = "ST";
+
+    // Special paths
+    const String STDIN = "-";
+    const String CONF = "conf";
+
+    // Commands
+    const String CONVERT = "convert";
+    const String GEN = "gen";
+
+    // Synthetic patterns (optionally followed by ':' and a parameter)
+    const String GEN_RANDOM = "random";
+    const String GEN_GROUPS = "groups";
+    const String GEN_STREAM = "stream";
+    const String GEN_STRIDE = "stride";
+    const String GEN_ZIPF = "zipf";
+    const String GEN_CHASE = "chase";
+
+    // Options
+    const String OPTION = "--";
+    const String CURVE = "--curve";
+    const String ASSOC = "--assoc";
+    const String SAMPLE_SETS = "--sample-sets";
+    const String CLASSIFY = "--classify";
+    const String THREADS = "--threads";
+    const String BATCH = "--batch";
+    const String SEED = "--seed";
+    const String OUTPUT = "--output";
+    const String BINARY = "--binary";
+    const String WARMUP = "--warmup";
+    const String SAVE = "--save";
+    const String RESTORE = "--restore";
+    const String LOG = "--log";
+    const String EPOCH = "--epoch";
+    const String INTERVAL = "--interval";
+    const String STATS = "--stats";
+    const String JSON = "--json";
 }
@@ -0,0 +1,101 @@
+#include <cstring>
+#include "trace.hh"
+#include "types.hh"
+
+trace::Header::Header() {
+    this->version = trace::VERSION;
+    this->chunk_records = trace::CHUNK_RECORDS;
+    this->count = 0;
+    this->index = 0;
+}
+
+bool trace::Header::decode(const u8 *data, u64 size) {
+    if (size < trace::HEADER_SIZE || memcmp(data, trace::MAGIC, sizeof(trace::MAGIC)) != 0) {
+        return false;
+    }
+    this->version = (u32)trace::get_u64(data + 8);
+    this->chunk_records = (u32)(trace::get_u64(data + 8) >> 32);
+    this->count = trace::get_u64(data + 16);
+    this->index = trace::get_u64(data + 24);
+    return true;
+}
+
+void trace::Header::encode(u8 *data) {
+    memcpy(data, trace::MAGIC, sizeof(trace::MAGIC));
+    trace::put_u64(data + 8, (u64)this->chunk_records << 32 | this->version);
+    trace::put_u64(data + 16, this->count);
+    trace::put_u64(data + 24, this->index);
+}
+
+u64 trace::encode(u64 previous, u64 address) {
+    // Zigzag the wrapping delta so small negative steps stay small
+    auto delta = (i64)(address - previous);
+    return ((u64)delta << 1) ^ (u64)(delta >> 63);
+}
+
+u64 trace::decode(u64 previous, u64 zigzag) {
+    return previous + ((zigzag >> 1) ^ (0 - (zigzag & 1)));
+}
+
+u8 *trace::put_record(u8 *data, u64 zigzag, bool store, bool switched) {
+    // A varint of the zigzag shifted left by two with the store and core
+    // switch bits below it, without losing the zigzag's top bits
+    auto rest = zigzag >> 5;
+    *data++ = (u8)((zigzag & 0x1F) << 2 | (switched ? 2 : 0) | (store ? 1 : 0) | (rest > 0 ? 0x80 : 0));
+    return rest > 0 ? trace::put_varint(data, rest) : data;
+}
+
+const u8 *trace::get_record(const u8 *data, const u8 *end, u32 version, u64 &zigzag, bool &store, bool &switched) {
+    // Returns NULL if the record runs past the end of the data (records
+    // before version 3 have no core switch bit)
+    if (data == end) {
+        return NULL;
+    }
+    auto byte = *data++;
+    auto shift = version > trace::VERSION_64 ? 2 : 1;
+    store = (byte & 1) != 0;
+    switched = version > trace::VERSION_64 && (byte & 2) != 0;
+    zigzag = (byte & 0x7F) >> shift;
+    if (byte >= 0x80) {
+        u64 rest = 0;
+        data = trace::get_varint(data, end, rest);
+        zigzag |= rest << (7 - shift);
+    }
+    return data;
+}
+
+u8 *trace::put_varint(u8 *data, u64 value) {
+    while (value >= 0x80) {
+        *data++ = (u8)value | 0x80;
+        value >>= 7;
+    }
+    *data++ = (u8)value;
+    return data;
+}
+
+const u8 *trace::get_varint(const u8 *data, const u8 *end, u64 &value) {
+    // Returns NULL if the varint runs past the end of the data
+    value = 0;
+    for (u32 shift = 0; data < end && shift < 64; shift += 7) {
+        auto byte = *data++;
+        value |= (u64)(byte & 0x7f) << shift;
+        if (byte < 0x80) {
+            return data;
+        }
+    }
+    return NULL;
+}
+
+u64 trace::get_u64(const u8 *data) {
+    u64 value = 0;
+    for (auto i = 7; i >= 0; i--) {
+        value = value << 8 | data[i];
+    }
+    return value;
+}
+
+void trace::put_u64(u8 *data, u64 value) {
+    for (auto i = 0; i < 8; i++) {
+        data[i] = (u8)(value >> (i * 8));
+    }
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include "types.hh"
+
+namespace trace {
+    // Binary trace layout (all integers are little-endian):
+    //   [0, 8)   magic
+    //   [8, 12)  version
+    //   [12, 16) records per chunk
+    //   [16, 24) record count
+    //   [24, 32) chunk index offset (one u64 file offset per chunk)
+    // Each record is a varint of the zigzag address delta shifted left by two,
+    // with the store bit in bit zero and a core switch bit in bit one (up to
+    // 66 bits, so any 64-bit delta fits). A core switch is followed by the new
+    // core as a varint. The delta and the core restart from zero at the
+    // beginning of every chunk so chunks can be decoded independently.
+    // Version 2 traces have no core switch bit (the delta is shifted left by
+    // one) and version 1 traces also hold 32-bit addresses whose deltas wrap
+    // at 32 bits.
+    const u8 MAGIC[] = {'C', 'S', 'I', 'M', 'T', 'R', 'C', 0x00};
+    const u32 VERSION = 3;
+    const u32 VERSION_64 = 2;
+    const u32 VERSION_32 = 1;
+    const u32 CHUNK_RECORDS = 64 * 1024;
+    const u64 HEADER_SIZE = 32;
+    const u64 MAX_VARINT = 10;
+    const u64 MAX_RECORD = 2 * MAX_VARINT;
+
+    class Header {
+        public:
+            u32 version;
+            u32 chunk_records;
+            u64 count;
+            u64 index;
+            Header();
+            bool decode(const u8*, u64);
+            void encode(u8*);
+    };
+
+    u64 encode(u64, u64);
+    u64 decode(u64, u64);
+    u8 *put_record(u8*, u64, bool, bool);
+    const u8 *get_record(const u8*, const u8*, u32, u64&, bool&, bool&);
+    u8 *put_varint(u8*, u64);
+    const u8 *get_varint(const u8*, const u8*, u64&);
+    u64 get_u64(const u8*);
+    void put_u64(u8*, u64);
+}
@@ -1,8 +1,13 @@
 #pragma once
+#include <atomic>
 #include <cstdint>
 #include <deque>
+#include <functional>
 #include <fstream>
+#include <memory>
+#include <mutex>
 #include <sstream>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -19,7 +24,15 @@ using f64 = double;
 
 using String = std::string;
 using FileReader = std::ifstream;
+using FileWriter = std::ofstream;
 using StringBuilder = std::ostringstream;
+using StringReader = std::istringstream;
+using InputStream = std::istream;
+using Mutex = std::mutex;
+using Thread = std::thread;
+template <typename T> using Atomic = std::atomic<T>;
+template <typename F> using Function = std::function<F>;
+template <typename T> using Shared = std::shared_ptr<T>;
 template <typename K, typename V> using HashMap = std::unordered_map<K, V>;
 template <typename V> using Deque = std::deque<V>;
 template <typename V> using Vector = std::vector<V>;
@@ -1,11 +1,16 @@
 #include <algorithm>
 #include <cmath>
 #include <iostream>
-#include "block.hh"
+#include "associativity.hh"
 #include "chars.hh"
+#include "classifier.hh"
 #include "consts.hh"
+#include "curve.hh"
+#include "engine.hh"
+#include "policy.hh"
 #include "exceptions.hh"
-#include "result.hh"
+#include "sample.hh"
+#include "snapshot.hh"
 #include "text.hh"
 #include "types.hh"
 #include "unit.hh"
@@ -16,285 +21,600 @@ Unit::Unit() {
     this->level = 0;
     this->write_hit_policy = 0;
     this->write_miss_policy = 0;
+    this->replacement = consts::LRU;
     this->block_size = 0;
     this->way = 0;
     this->set_count = 0;
     this->hit_time = 0;
     this->size = 0;
+    this->sample_rate = 1;
+    this->core_count = 0;
+    this->coherence = 0;
     this->full = false;
 
+    // Address decomposition
+    this->offset_width = 0;
+    this->tag_shift = 0;
+    this->set_mask = 0;
+
     // Access properties
     this->access_time = 0;
     this->hit_count = 0;
     this->miss_count = 0;
+    this->eviction_count = 0;
+    this->writeback_count = 0;
     this->next = NULL;
+    this->port = NULL;
+    this->recent = false;
+    this->recent_block = 0;
+    this->recent_line = NULL;
+    this->recent_slot = 0;
+
+    // Access methods
+    this->reader = NULL;
+    this->writer = NULL;
 
     // Cache types
-    this->mmap = Deque<Block>();
-    this->dmap = HashMap<u32, Block>();
-    this->nmap = HashMap<u32, Deque<Block>>();
+    this->table = Table();
+    this->storage = Storage();
+
+    // Analysis
+    this->curve = NULL;
+    this->associativity = NULL;
+    this->sample = NULL;
+    this->classifier = NULL;
 }
 
 Unit::~Unit() {
     if (this->next != NULL) {
         delete this->next;
     }
+    if (this->port != NULL) {
+        delete this->port;
+    }
+    if (this->curve != NULL) {
+        delete this->curve;
+    }
+    if (this->associativity != NULL) {
+        delete this->associativity;
+    }
+    if (this->sample != NULL) {
+        delete this->sample;
+    }
+    if (this->classifier != NULL) {
+        delete this->classifier;
+    }
 }
 
-void Unit::score() {
+void Unit::score(f64 scale) {
+    // Sampled levels (and every level below them, which only sees their
+    // sampled traffic) report estimates scaled up to the full access count
+    scale *= this->get_scale();
     if (this->level == consts::MAIN) {
-        cout << "Level: " << "Main" << endl;
+        cout << "Level: " << "Main" << "\n";
     } else {
-        cout << "Level: " << (u16)this->level << endl;
+        cout << "Level: " << (u16)this->level << "\n";
     }
-    cout << "HitCount: " << this->hit_count << endl
-        << "MissCount: " << this->miss_count << endl
-        << "AccessCount: " << this->hit_count + this->miss_count << endl
-        << "AccessTime: " << this->access_time << endl;
-    if (this->next != NULL) {
-        cout << endl;
-        this->next->score();
-    }
-}
-
-Result Unit::load(u32 addr) {
-    auto result = this->access(false, addr);
-    this->access_time += this->hit_time;
-    result.add_time(this->hit_time);
-    if (result.get_status() == consts::HIT) {
-        // Load hit stops immediately
-        this->hit_count += 1;
-    } else if (result.get_status() == consts::MISS) {
-        // Load miss descends to the next level
-        this->miss_count += 1;
-        auto time = this->next->load(addr).get_time();
-        this->access_time += time;
-        result.add_time(time);
-    } else if (result.get_status() == consts::DIRTY) {
-        // Dirty loads will trigger a store and retry - no need to accumulate
-        // time on the same level
-        auto time = this->next->store(result.get_address()).get_time();
-        this->access_time += time;
-        result.add_time(time);
-        // Retry (will miss) -- subtract repeat
-        time = this->load(addr).get_time() - this->hit_time;
-        this->access_time -= this->hit_time;
-        result.add_time(time);
-    }
-    return result;
-}
-
-Result Unit::store(u32 addr) {
-    auto result = this->access(true, addr);
-    this->access_time += this->hit_time;
-    result.add_time(this->hit_time);
-    if (result.get_status() == consts::HIT) {
-        // Write hit behavior depends on the policy
-        this->hit_count += 1;
-        if (this->write_hit_policy == consts::WRITE_THROUGH) {
-            // Write through descends to the next level
-            auto time = this->next->store(addr).get_time();
-            this->access_time += time;
-            result.add_time(time);
+    if (scale == 1.0) {
+        cout << "HitCount: " << this->hit_count << "\n"
+            << "MissCount: " << this->miss_count << "\n"
+            << "AccessCount: " << this->hit_count + this->miss_count << "\n"
+            << "AccessTime: " << this->access_time << "\n";
+    } else {
+        cout << "HitCount: " << llround(this->hit_count * scale) << "\n"
+            << "MissCount: " << llround(this->miss_count * scale) << "\n"
+            << "AccessCount: " << llround((this->hit_count + this->miss_count) * scale) << "\n"
+            << "AccessTime: " << llround(this->access_time * scale) << "\n";
+    }
+    if (this->sample != NULL) {
+        // The sampled miss ratio with its 95% confidence interval, and the
+        // miss count it implies
+        auto total = this->sample->get_access_count() + this->sample->get_skip_count();
+        auto ratio = this->sample->get_miss_ratio();
+        auto margin = this->sample->get_margin();
+        cout << "Sample:" << "\n"
+            << "  Rate: 1/" << this->sample->get_rate()
+            << " Sets: " << this->sample->get_sampled_sets()
+            << " SetCount: " << this->sample->get_set_count()
+            << " AccessCount: " << this->sample->get_access_count()
+            << " SkipCount: " << this->sample->get_skip_count() << "\n"
+            << "  MissRatio: " << ratio << " +/- " << margin << "\n"
+            << "  MissCount: " << llround(total * ratio) << " +/- " << llround(total * margin) << "\n";
+    }
+    if (this->curve != NULL) {
+        // Fully associative LRU hit and miss counts at every power of two
+        // up to the size where only compulsory misses remain
+        auto total = this->curve->get_access_count();
+        cout << "Curve:" << "\n";
+        for (u64 lines = 1; ; lines *= 2) {
+            auto hits = this->curve->get_hit_count(lines);
+            cout << "  Size: " << lines * this->block_size
+                << " HitCount: " << hits
+                << " MissCount: " << total - hits << "\n";
+            if (lines >= this->curve->get_max_distance()) {
+                break;
+            }
         }
-        // Write back stops immediately
-    } else if (result.get_status() == consts::MISS) {
-        // Write miss behavior depends on the policy
-        this->miss_count += 1;
-        if (this->write_miss_policy == consts::WRITE_ALLOCATE_ON) {
-            // Write allocation will load the block and retry - no need to
-            // accumulate time on the same level
-            auto time = this->load(addr).get_time() - this->hit_time;
-            this->access_time -= this->hit_time;
-            result.add_time(time);
-            this->miss_count -= 1;
-            // Retry (will hit) -- subtract repeat
-            time = this->store(addr).get_time() - this->hit_time;
-            this->access_time -= this->hit_time;
-            result.add_time(time);
-            this->hit_count -= 1;
-        } else {
-            // No write allocation descends to the next level
-            auto time = this->next->store(addr).get_time();
-            this->access_time += time;
-            result.add_time(time);
+    }
+    if (this->associativity != NULL) {
+        // Set associative LRU hit and miss counts for every power of two set
+        // count up to the configured one and every way up to the bound
+        auto total = this->associativity->get_access_count();
+        cout << "Associativity:" << "\n";
+        for (u32 bits = 0; bits <= this->associativity->get_set_bits(); bits++) {
+            for (u32 way = 1; way <= this->associativity->get_way(); way++) {
+                auto hits = this->associativity->get_hit_count(bits, way);
+                cout << "  Sets: " << (1ULL << bits)
+                    << " Way: " << way
+                    << " HitCount: " << hits
+                    << " MissCount: " << total - hits
+                    << " AccessCount: " << total << "\n";
+            }
         }
-    } else if (result.get_status() == consts::DIRTY) {
-        // Dirty writes have no meaning
     }
-    return result;
+    if (this->classifier != NULL) {
+        // Why the misses happened, and the lines they displaced
+        cout << "Misses:" << "\n"
+            << "  Compulsory: " << this->classifier->get_compulsory_count()
+            << " Capacity: " << this->classifier->get_capacity_count()
+            << " Conflict: " << this->classifier->get_conflict_count() << "\n"
+            << "  EvictionCount: " << this->eviction_count
+            << " WritebackCount: " << this->writeback_count << "\n";
+    }
+    if (this->next != NULL && this->next->port == NULL) {
+        cout << "\n";
+        this->next->score(scale);
+    }
 }
 
-Result Unit::access(bool store, u32 addr) {
-    // Main memory always hits
-    if (this->level == consts::MAIN) {
-        return Result(consts::HIT);
+u32 Unit::load(u64 addr) {
+    if (this->sample != NULL) {
+        // Only sampled sets reach the lookup
+        auto set = (u32)(addr >> this->offset_width) & this->set_mask;
+        if (!this->sample->is_sampled(set)) {
+            return this->skip();
+        }
+        auto misses = this->miss_count;
+        auto time = this->reader(*this, addr);
+        this->sample->record(set, this->miss_count - misses);
+        return time;
+    }
+    if (this->curve != NULL) {
+        this->curve->touch(addr >> this->offset_width);
+    }
+    if (this->associativity != NULL) {
+        this->associativity->touch(addr >> this->offset_width);
     }
+    if (this->classifier != NULL) {
+        // The shadow cache only allocates when the level does
+        this->classifier->touch(addr, true);
+        auto misses = this->miss_count;
+        auto time = this->reader(*this, addr);
+        this->classifier->classify(this->miss_count - misses);
+        return time;
+    }
+    return this->reader(*this, addr);
+}
 
-    // Compute bit widths
-    u32 setw = round(log2(this->set_count));
-    u32 offsw = round(log2(this->block_size));
+u32 Unit::store(u64 addr) {
+    if (this->sample != NULL) {
+        // Only sampled sets reach the lookup
+        auto set = (u32)(addr >> this->offset_width) & this->set_mask;
+        if (!this->sample->is_sampled(set)) {
+            return this->skip();
+        }
+        auto misses = this->miss_count;
+        auto time = this->writer(*this, addr);
+        this->sample->record(set, this->miss_count - misses);
+        return time;
+    }
+    if (this->curve != NULL) {
+        this->curve->touch(addr >> this->offset_width);
+    }
+    if (this->associativity != NULL) {
+        this->associativity->touch(addr >> this->offset_width);
+    }
+    if (this->classifier != NULL) {
+        // The shadow cache only allocates when the level does
+        this->classifier->touch(addr, this->write_miss_policy == consts::WRITE_ALLOCATE_ON);
+        auto misses = this->miss_count;
+        auto time = this->writer(*this, addr);
+        this->classifier->classify(this->miss_count - misses);
+        return time;
+    }
+    return this->writer(*this, addr);
+}
 
-    // Compute bit masks
-    u32 tagm = 0xffffffff << (offsw + setw);
-    u32 setm = ~tagm & (0xffffffff << offsw);
+u32 Unit::skip() {
+    // Skipped accesses stand in with the mean time of the sampled ones, so
+    // the levels above still accumulate a sensible time estimate
+    this->sample->skip();
+    auto count = this->hit_count + this->miss_count;
+    return count > 0 ? (u32)llround((f64)this->access_time / count) : this->hit_time;
+}
 
-    // Break apart address
-    u32 tag = (tagm & addr) >> (offsw + setw);
-    u32 set = (setm & addr) >> offsw;
+bool Unit::is_valid() {
+    if (this->level == consts::MAIN) {
+        return true;
+    }
+    return this->level > 0
+        && this->write_hit_policy > 0
+        && this->write_miss_policy > 0
+        && this->block_size > 0
+        && this->size > 0;
+}
 
-    // Access the appropriate cache
-    if (this->way == 1) {
-        return this->access_dmap(store, addr, tag, set);
-    } else if (this->set_count == 1) {
-        return this->access_mmap(store, addr, tag, set);
-    }
-    return this->access_nmap(store, addr, tag, set);
-}
-
-Result Unit::access_mmap(bool store, u32 addr, u32 tag, u32 set) {
-    // Fully associative cache algorithm (LRU)
-    auto index = find(this->mmap.begin(), this->mmap.end(), tag);
-    if (index == this->mmap.end()) {
-        // The tag could not be found (miss)
-        if (!store) {
-            if (this->mmap.size() == this->way) {
-                // The cache doesn't have room (eviction)
-                auto &block = this->mmap[this->mmap.size() - 1];
-                if (block.get_dirty()) {
-                    // The block is dirty so the controller must write this
-                    // block to the next memory unit and restart the current
-                    // operation
-                    block.set_dirty(false);
-                    return Result(consts::DIRTY, block.get_address());
-                }
-                // Read only: pop the last block
-                this->mmap.pop_back();
-            }
-            // Read only: push the new block
-            this->mmap.push_front(Block(addr, tag));
+bool Unit::is_feasible() {
+    // The geometry must leave at least one set and suit the replacement
+    // policy (checked after finalizing)
+    if (this->level != consts::MAIN) {
+        if (this->way == 0 || this->set_count == 0) {
+            return false;
+        }
+        // Tags are stored above the line state bits, so the line and set
+        // index must cover at least as many address bits
+        if (this->tag_shift < consts::LINE_BITS) {
+            return false;
+        }
+        auto organisation = this->get_organisation();
+        if (organisation == consts::FULLY_ASSOCIATIVE && (this->replacement != consts::LRU || this->sample_rate > 1)) {
+            return false;
+        }
+        if (organisation == consts::SET_ASSOCIATIVE && !policy::is_supported(this->replacement, this->way)) {
+            return false;
         }
-        return Result(consts::MISS);
     }
+    return this->next == NULL || this->next->is_feasible();
+}
 
-    // The tag was found (hit + move to front)
-    auto value = *index;
-    if (store && this->write_hit_policy == consts::WRITE_BACK) {
-        // Write only: set the dirty bit on write hit + write back
-        value.set_dirty(true);
+u32 Unit::enable_curve() {
+    // Track the stack distance of every fully associative level (the curve is
+    // only exact when every access allocates) and return the level count
+    u32 count = 0;
+    if (this->level != consts::MAIN && this->full) {
+        if (this->write_miss_policy != consts::WRITE_ALLOCATE_ON) {
+            throw RuntimeException("'curve' requires write allocation on fully associative levels");
+        }
+        this->curve = new Curve();
+        count += 1;
+    }
+    if (this->next != NULL) {
+        count += this->next->enable_curve();
     }
+    return count;
+}
 
-    // Read + write: move the block to the front
-    this->mmap.erase(index);
-    this->mmap.push_front(value);
-    return Result(consts::HIT);
+u32 Unit::enable_associativity(u32 way) {
+    // Track every set count and associativity on the set associative and
+    // direct mapped levels that allocate on every access (other levels are
+    // not stack algorithms) and return the level count
+    u32 count = 0;
+    if (
+        this->level != consts::MAIN &&
+        !this->full &&
+        this->write_miss_policy == consts::WRITE_ALLOCATE_ON
+    ) {
+        u32 setw = round(log2(this->set_count));
+        this->associativity = new Associativity(setw, way);
+        count += 1;
+    }
+    if (this->next != NULL) {
+        count += this->next->enable_associativity(way);
+    }
+    return count;
 }
 
-Result Unit::access_dmap(bool store, u32 addr, u32 tag, u32 set) {
-    // Direct mapped cache algorithm
-    if (this->dmap.find(set) == this->dmap.end()) {
-        // The block is invalid (compulsory miss)
-        if (!store) {
-            // Read only: 'load' the block
-            this->dmap[set] = Block(addr, tag);
-        }
-        return Result(consts::MISS);
+u32 Unit::enable_sampling(u32 rate) {
+    // Sample the last level before main memory (if it has sets to sample)
+    // and return the level count
+    if (this->next == NULL) {
+        return 0;
+    } else if (this->next->level != consts::MAIN) {
+        return this->next->enable_sampling(rate);
+    } else if (this->level == consts::MAIN || this->get_organisation() == consts::FULLY_ASSOCIATIVE) {
+        return 0;
+    }
+    if (this->sample != NULL) {
+        delete this->sample;
+        this->sample = NULL;
+    }
+    this->sample_rate = rate;
+    if (rate > 1) {
+        this->sample = new Sample(rate, this->set_mask + 1);
     }
+    return 1;
+}
 
-    // The block is valid and the tags match (hit)
-    if (this->dmap[set] == tag) {
-        if (store && this->write_hit_policy == consts::WRITE_BACK) {
-            // Write only: set the dirty bit on write hit + write back
-            this->dmap[set].set_dirty(true);
-        }
-        return Result(consts::HIT);
+u32 Unit::enable_classification() {
+    // Classify the misses of every level that simulates every access (the
+    // shadow cache holds as many lines as the level) and return the level
+    // count
+    u32 count = 0;
+    if (this->level != consts::MAIN && this->sample == NULL) {
+        auto lazy = this->size >= consts::LAZY_SIZE;
+        this->classifier = new Classifier(this->size / this->block_size, this->offset_width, lazy);
+        count += 1;
     }
+    if (this->next != NULL) {
+        count += this->next->enable_classification();
+    }
+    return count;
+}
 
-    // The block is valid but the tags do not match (miss + eviction)
-    if (!store) {
-        if (this->dmap[set].get_dirty()) {
-            // The block is dirty so the controller must write this block to
-            // the next memory unit and restart the current operation
-            this->dmap[set].set_dirty(false);
-            return Result(consts::DIRTY, this->dmap[set].get_address());
-        }
-        // Read only: 'load' the block
-        this->dmap[set] = Block(addr, tag);
-    }
-    return Result(consts::MISS);
-}
-
-Result Unit::access_nmap(bool store, u32 addr, u32 tag, u32 set) {
-    // Set associative cache algorithm (LRU)
-    auto set_index = this->nmap.find(set);
-    if (set_index == this->nmap.end()) {
-        // The line is invalid (compulsory miss)
-        if (!store) {
-            // Read only: 'load' the block
-            auto deque = Deque<Block>();
-            deque.push_front(Block(addr, tag));
-            this->nmap[set] = deque;
+void Unit::partition(u32 &low, u32 &high) {
+    // Narrows [low, high) to the address bits that are part of the set index
+    // on every level, so the sets of every level split along them (analysis
+    // depends on the order of every access, so it can't be split)
+    if (this->level != consts::MAIN) {
+        if (this->curve != NULL || this->associativity != NULL || this->sample != NULL || this->classifier != NULL) {
+            high = low;
         }
-        return Result(consts::MISS);
-    }
-
-    // The line is valid
-    auto &deque = set_index->second;
-    auto block_index = find(deque.begin(), deque.end(), tag);
-    if (block_index == deque.end()) {
-        // The tag could not be found (miss)
-        if (!store) {
-            if (deque.size() == this->way) {
-                // The set doesn't have room (eviction)
-                auto &block = deque[deque.size() - 1];
-                if (block.get_dirty()) {
-                    // The block is dirty so the controller must write this
-                    // block to the next memory unit and restart the current
-                    // operation
-                    block.set_dirty(false);
-                    return Result(consts::DIRTY, block.get_address());
-                }
-                // Read only: pop the last block
-                deque.pop_back();
+        low = max(low, this->offset_width);
+        high = min(high, this->tag_shift);
+    }
+    if (this->next != NULL) {
+        this->next->partition(low, high);
+    }
+}
+
+void Unit::reserve() {
+    // Allocate the lazy storage up front (forks can't allocate concurrently)
+    this->storage.reserve();
+    if (this->next != NULL) {
+        this->next->reserve();
+    }
+}
+
+Unit *Unit::fork() {
+    // A copy of the hierarchy that shares the lines but keeps its own counters
+    auto *unit = new Unit();
+    unit->level = this->level;
+    unit->write_hit_policy = this->write_hit_policy;
+    unit->write_miss_policy = this->write_miss_policy;
+    unit->replacement = this->replacement;
+    unit->block_size = this->block_size;
+    unit->way = this->way;
+    unit->hit_time = this->hit_time;
+    unit->set_count = this->set_count;
+    unit->size = this->size;
+    unit->full = this->full;
+    unit->offset_width = this->offset_width;
+    unit->tag_shift = this->tag_shift;
+    unit->set_mask = this->set_mask;
+    unit->storage = this->storage;
+    unit->reader = this->reader;
+    unit->writer = this->writer;
+    if (this->next != NULL) {
+        unit->next = this->next->fork();
+    }
+    this->forget();
+    return unit;
+}
+
+void Unit::merge(Unit *unit) {
+    // Add the counters of a fork (which may have replaced the recent line)
+    this->forget();
+    this->hit_count += unit->hit_count;
+    this->miss_count += unit->miss_count;
+    this->eviction_count += unit->eviction_count;
+    this->writeback_count += unit->writeback_count;
+    this->access_time += unit->access_time;
+    if (this->next != NULL) {
+        this->next->merge(unit->next);
+    }
+}
+
+void Unit::reset() {
+    // Clear the statistics but keep the lines (and the history the analyses
+    // need to stay warm)
+    this->hit_count = 0;
+    this->miss_count = 0;
+    this->eviction_count = 0;
+    this->writeback_count = 0;
+    this->access_time = 0;
+    if (this->curve != NULL) {
+        this->curve->reset();
+    }
+    if (this->associativity != NULL) {
+        this->associativity->reset();
+    }
+    if (this->sample != NULL) {
+        this->sample->reset();
+    }
+    if (this->classifier != NULL) {
+        this->classifier->reset();
+    }
+    if (this->next != NULL) {
+        this->next->reset();
+    }
+}
+
+bool Unit::revoke(u64 addr, u64 size, bool invalidate) {
+    // Drops (or cleans) the lines of [addr, addr + size) on this and the
+    // private levels below, returning whether any of them was dirty
+    if (this->port != NULL) {
+        return false;
+    }
+    this->forget();
+    bool dirty = false;
+    auto full = this->get_organisation() == consts::FULLY_ASSOCIATIVE;
+    auto last = (addr + size - 1) >> this->offset_width;
+    for (auto line = addr >> this->offset_width; line <= last; line++) {
+        u64 tag = line >> (this->tag_shift - this->offset_width);
+        if (full) {
+            auto slot = this->table.find(tag);
+            if (slot == consts::NO_SLOT) {
+                continue;
+            }
+            dirty = dirty || this->table.get_dirty(slot);
+            if (invalidate) {
+                this->table.remove(slot);
+            } else {
+                this->table.set_dirty(slot, false);
+            }
+        } else {
+            auto lines = this->storage.get((u32)line & this->set_mask);
+            auto index = lines.find(tag);
+            if (index == this->way) {
+                continue;
+            }
+            dirty = dirty || lines.get_dirty(index);
+            if (invalidate) {
+                lines.clear(index);
+            } else {
+                lines.set_dirty(index, false);
             }
-            // Read only: push the new block
-            deque.push_front(Block(addr, tag));
         }
-        return Result(consts::MISS);
     }
+    auto below = this->next->revoke(addr, size, invalidate);
+    return dirty || below;
+}
 
-    // The tag was found (hit + move to front)
-    auto value = *block_index;
-    if (store && this->write_hit_policy == consts::WRITE_BACK) {
-        // Write only: set the dirty bit on write hit + write back
-        value.set_dirty(true);
-    }
+void Unit::forget() {
+    // The recent line may no longer be where it was
+    this->recent = false;
+}
 
-    // Read + write: move the block to the front
-    deque.erase(block_index);
-    deque.push_front(value);
-    return Result(consts::HIT);
+void Unit::add_time(u32 time) {
+    // Adds the time the shared levels took to this and the private levels
+    // below (every request to the shared levels passed through all of them)
+    if (this->port == NULL) {
+        this->access_time += time;
+        this->next->add_time(time);
+    }
 }
 
-bool Unit::is_valid() {
-    if (this->level == consts::MAIN) {
+bool Unit::is_analysed() {
+    // The analyses keep state of their own that snapshots don't cover
+    if (this->curve != NULL || this->associativity != NULL || this->sample != NULL || this->classifier != NULL) {
         return true;
     }
-    return this->level > 0
-        && this->write_hit_policy > 0
-        && this->write_miss_policy > 0
-        && this->block_size > 0
-        && this->size > 0;
+    return this->next != NULL && this->next->is_analysed();
+}
+
+void Unit::save(SnapshotWriter &writer) {
+    writer.put(this->level);
+    writer.put(this->write_hit_policy);
+    writer.put(this->write_miss_policy);
+    writer.put(this->replacement);
+    writer.put(this->block_size);
+    writer.put(this->way);
+    writer.put(this->set_count);
+    writer.put(this->size);
+    writer.put(this->hit_time);
+    writer.put(this->hit_count);
+    writer.put(this->miss_count);
+    writer.put(this->eviction_count);
+    writer.put(this->writeback_count);
+    writer.put(this->access_time);
+    if (this->get_organisation() == consts::FULLY_ASSOCIATIVE) {
+        this->table.save(writer);
+    } else if (this->level != consts::MAIN) {
+        this->storage.save(writer);
+    }
+    if (this->next != NULL) {
+        this->next->save(writer);
+    }
+}
+
+void Unit::restore(SnapshotReader &reader) {
+    reader.expect(this->level);
+    reader.expect(this->write_hit_policy);
+    reader.expect(this->write_miss_policy);
+    reader.expect(this->replacement);
+    reader.expect(this->block_size);
+    reader.expect(this->way);
+    reader.expect(this->set_count);
+    reader.expect(this->size);
+    reader.expect(this->hit_time);
+    this->hit_count = reader.get();
+    this->miss_count = reader.get();
+    this->eviction_count = reader.get();
+    this->writeback_count = reader.get();
+    this->access_time = reader.get();
+    this->forget();
+    if (this->get_organisation() == consts::FULLY_ASSOCIATIVE) {
+        this->table.restore(reader);
+    } else if (this->level != consts::MAIN) {
+        this->storage.restore(reader);
+    }
+    if (this->next != NULL) {
+        this->next->restore(reader);
+    }
 }
 
 void Unit::finalize() {
     // Compute the associativity if 'full'
     if (this->full) {
-        this->way = (u16)(this->size / (u32)this->block_size);
+        this->way = this->size / (u32)this->block_size;
     }
     // Update the set count if the information is available
     if (this->set_count == 0 && this->way > 0 && this->size > 0 && this->block_size > 0) {
-        this->set_count = this->size / (u32)this->block_size / (u32)this->way;
+        this->set_count = this->size / (u32)this->block_size / this->way;
+    }
+    // Compute the bit widths and masks once
+    if (this->level != consts::MAIN && this->block_size > 0 && this->set_count > 0) {
+        u32 setw = round(log2(this->set_count));
+        this->offset_width = round(log2(this->block_size));
+        this->tag_shift = this->offset_width + setw;
+        this->set_mask = (u32)((1ULL << setw) - 1);
+    }
+    // Allocate the set storage (the set index is rounded to a whole number
+    // of bits, so the storage covers every index it can produce)
+    auto lazy = this->size >= consts::LAZY_SIZE;
+    this->forget();
+    if (this->get_organisation() == consts::FULLY_ASSOCIATIVE) {
+        this->table.allocate(this->way, lazy);
+    } else if (this->level != consts::MAIN) {
+        auto words = policy::get_words(this->replacement, this->way);
+        auto ranked = policy::is_ranked(this->replacement, this->way);
+        this->storage.allocate(this->set_mask + 1, this->way, words, ranked, lazy);
+    }
+    // Sample a subset of the sets if requested
+    if (this->sample_rate > 1 && this->get_organisation() != consts::FULLY_ASSOCIATIVE && this->level != consts::MAIN) {
+        this->sample = new Sample(this->sample_rate, this->set_mask + 1);
+    }
+}
+
+f64 Unit::get_scale() {
+    if (this->sample == NULL) {
+        return 1.0;
+    }
+    return this->sample->get_scale();
+}
+
+u8 Unit::get_organisation() {
+    if (this->level == consts::MAIN) {
+        return consts::MAIN_MEMORY;
+    } else if (this->way == 1) {
+        return consts::DIRECT_MAPPED;
+    } else if (this->set_count == 1) {
+        return consts::FULLY_ASSOCIATIVE;
+    }
+    return consts::SET_ASSOCIATIVE;
+}
+
+void Unit::specialize() {
+    // Bind the engine for this organisation, replacement policy, write
+    // policy pair and line size
+    auto organisation = this->get_organisation();
+    auto hit = this->write_hit_policy;
+    auto miss = this->write_miss_policy;
+    if (this->port != NULL) {
+        this->reader = &Port::read;
+        this->writer = &Port::write;
+    } else if (organisation == consts::MAIN_MEMORY) {
+        this->reader = &Engine<consts::MAIN_MEMORY, RankedLru, 0, 0, 0>::read;
+        this->writer = &Engine<consts::MAIN_MEMORY, RankedLru, 0, 0, 0>::write;
+    } else if (organisation == consts::DIRECT_MAPPED) {
+        engine::bind<consts::DIRECT_MAPPED, RankedLru>(hit, miss, this->offset_width, this->reader, this->writer);
+    } else if (organisation == consts::FULLY_ASSOCIATIVE) {
+        engine::bind<consts::FULLY_ASSOCIATIVE, RankedLru>(hit, miss, this->offset_width, this->reader, this->writer);
+    } else {
+        engine::bind<consts::SET_ASSOCIATIVE>(this->replacement, this->way, hit, miss, this->offset_width, this->reader, this->writer);
+    }
+    if (this->next != NULL) {
+        this->next->specialize();
     }
 }
 
@@ -306,6 +626,12 @@ void Unit::add_unit(Unit *unit) {
     }
 }
 
+void Unit::set_port(Port *port) {
+    // The port takes the place of main memory below the private levels
+    this->level = consts::MAIN;
+    this->port = port;
+}
+
 void Unit::set(String &key, String &value) {
     if (key.compare(text::LEVEL) == 0) {
         // Evaluate the level
@@ -328,6 +654,18 @@ void Unit::set(String &key, String &value) {
     } else if (key.compare(text::ALLOC_POLICY) == 0) {
         // Evaluate the write miss policy
         this->set_write_miss_policy(value);
+    } else if (key.compare(text::REPLACEMENT) == 0) {
+        // Evaluate the replacement policy
+        this->set_replacement(value);
+    } else if (key.compare(text::SAMPLE) == 0) {
+        // Evaluate the set sampling rate
+        this->set_sample(value);
+    } else if (key.compare(text::CORES) == 0) {
+        // Evaluate the core count of a private level
+        this->set_cores(value);
+    } else if (key.compare(text::COHERENCE) == 0) {
+        // Evaluate the coherence protocol
+        this->set_coherence(value);
     } else {
         throw FormatException("unrecognized key");
     }
@@ -365,6 +703,50 @@ void Unit::set_write_miss_policy(String &value) {
     }
 }
 
+void Unit::set_replacement(String &value) {
+    if (value.compare(text::LRU) == 0) {
+        this->replacement = consts::LRU;
+    } else if (value.compare(text::TREE_PLRU) == 0) {
+        this->replacement = consts::TREE_PLRU;
+    } else if (value.compare(text::SRRIP) == 0) {
+        this->replacement = consts::SRRIP;
+    } else if (value.compare(text::FIFO) == 0) {
+        this->replacement = consts::FIFO;
+    } else if (value.compare(text::RANDOM) == 0) {
+        this->replacement = consts::RANDOM;
+    } else {
+        throw FormatException("unrecognized replacement policy");
+    }
+}
+
+void Unit::set_sample(String &value) {
+    this->sample_rate = sample::parse_rate(value);
+    if (this->sample_rate == 0) {
+        throw FormatException("'sample' could not be parsed");
+    }
+}
+
+void Unit::set_cores(String &value) {
+    try {
+        this->core_count = (u32)stoul(value);
+    } catch (Exception &e) {
+        throw FormatException("'cores' could not be parsed");
+    }
+    if (this->core_count == 0 || this->core_count > consts::MAX_CORES) {
+        throw FormatException("'cores' is out of range");
+    }
+}
+
+void Unit::set_coherence(String &value) {
+    if (value.compare(text::MSI) == 0) {
+        this->coherence = consts::MSI;
+    } else if (value.compare(text::MESI) == 0) {
+        this->coherence = consts::MESI;
+    } else {
+        throw FormatException("unrecognized coherence protocol");
+    }
+}
+
 void Unit::set_block_size(String &value) {
     try {
         this->block_size = (u16)stoul(value);
@@ -378,7 +760,7 @@ void Unit::set_way(String &value) {
         this->full = true;
     } else {
         try {
-            this->way = (u16)stoul(value);
+            this->way = (u32)stoul(value);
         } catch (Exception &e) {
             throw FormatException("'way' could not be parsed");
         }
@@ -416,6 +798,49 @@ void Unit::set_size(String &value) {
     }
 }
 
+String Unit::get_label() {
+    if (this->level == consts::MAIN) {
+        return "Main";
+    }
+    return "L" + to_string((u16)this->level);
+}
+
+u64 Unit::get_hit_count() {
+    return this->hit_count;
+}
+
+u64 Unit::get_miss_count() {
+    return this->miss_count;
+}
+
+u64 Unit::get_eviction_count() {
+    return this->eviction_count;
+}
+
+u64 Unit::get_writeback_count() {
+    return this->writeback_count;
+}
+
+u64 Unit::get_access_time() {
+    return this->access_time;
+}
+
+u32 Unit::get_offset_width() {
+    return this->offset_width;
+}
+
+u32 Unit::get_core_count() {
+    return this->core_count;
+}
+
+u8 Unit::get_coherence() {
+    return this->coherence;
+}
+
+Unit *Unit::get_next() {
+    return this->next;
+}
+
 bool Unit::operator<(Unit &rhs) {
     return this->level < rhs.level;
 }
@@ -1,56 +1,127 @@
 #pragma once
-#include "block.hh"
-#include "result.hh"
+#include "associativity.hh"
+#include "classifier.hh"
+#include "curve.hh"
+#include "port.hh"
+#include "sample.hh"
+#include "snapshot.hh"
+#include "storage.hh"
+#include "table.hh"
 #include "types.hh"
 
+class Unit;
+using Handler = u32 (*)(Unit&, u64);
+
 class Unit {
     private:
         // Configuration properties
         u8 level;
         u8 write_hit_policy;
         u8 write_miss_policy;
+        u8 replacement;
         u16 block_size;
-        u16 way;
+        u32 way;
         u32 hit_time;
         u32 set_count;
         u32 size;
+        u32 sample_rate;
+        u32 core_count;
+        u8 coherence;
         bool full;
 
+        // Address decomposition (computed on finalize)
+        u32 offset_width;
+        u32 tag_shift;
+        u32 set_mask;
+
         // Access properties
-        u32 access_time;
-        u32 hit_count;
-        u32 miss_count;
+        u64 access_time;
+        u64 hit_count;
+        u64 miss_count;
+        u64 eviction_count;
+        u64 writeback_count;
         Unit *next;
 
+        // The line of the last hit (or write allocation), repeats of it hit
+        // without a lookup
+        bool recent;
+        u64 recent_block;
+        u64 *recent_line;
+        u32 recent_slot;
+        void forget();
+
+        // The shared levels of a multi-core hierarchy (stands in for main
+        // memory below a core's private levels)
+        Port *port;
+
         // Cache types
-        Deque<Block> mmap;
-        HashMap<u32, Block> dmap;
-        HashMap<u32, Deque<Block>> nmap;
+        Table table;
+        Storage storage;
+
+        // Analysis
+        Curve *curve;
+        Associativity *associativity;
+        Sample *sample;
+        Classifier *classifier;
+        u32 skip();
 
-        // Access methods
-        Result access(bool, u32);
-        Result access_mmap(bool, u32, u32, u32);
-        Result access_dmap(bool, u32, u32, u32);
-        Result access_nmap(bool, u32, u32, u32);
+        // Access methods (specialized engines bound on specialize)
+        Handler reader;
+        Handler writer;
+        template <u8, typename, u8, u8, u32> friend class Engine;
+        friend class Port;
 
         // Configuration methods
         void set_level(String&);
         void set_write_hit_policy(String&);
         void set_write_miss_policy(String&);
+        void set_replacement(String&);
         void set_block_size(String&);
         void set_way(String&);
         void set_hit_time(String&);
         void set_size(String&);
+        void set_sample(String&);
+        void set_cores(String&);
+        void set_coherence(String&);
 
     public:
         Unit();
         ~Unit();
-        Result load(u32);
-        Result store(u32);
+        u32 load(u64);
+        u32 store(u64);
         bool is_valid();
-        void score();
+        bool is_feasible();
+        bool is_analysed();
+        u32 enable_curve();
+        u32 enable_associativity(u32);
+        u32 enable_sampling(u32);
+        u32 enable_classification();
+        void partition(u32&, u32&);
+        void reserve();
+        Unit *fork();
+        void merge(Unit*);
+        void reset();
+        bool revoke(u64, u64, bool);
+        void add_time(u32);
+        void save(SnapshotWriter&);
+        void restore(SnapshotReader&);
+        void score(f64);
         void finalize();
+        void specialize();
         void add_unit(Unit*);
+        void set_port(Port*);
         void set(String&, String&);
+        String get_label();
+        u64 get_hit_count();
+        u64 get_miss_count();
+        u64 get_eviction_count();
+        u64 get_writeback_count();
+        u64 get_access_time();
+        f64 get_scale();
+        u8 get_organisation();
+        u32 get_offset_width();
+        u32 get_core_count();
+        u8 get_coherence();
+        Unit *get_next();
         bool operator<(Unit&);
 };
@@ -0,0 +1,87 @@
+#include "consts.hh"
+#include "exceptions.hh"
+#include "record.hh"
+#include "trace.hh"
+#include "types.hh"
+#include "writer.hh"
+
+Writer::Writer(const String &path) {
+    this->path = path;
+    this->file = FileWriter(path, FileWriter::binary | FileWriter::trunc);
+    this->buffer = Vector<u8>();
+    this->index = Vector<u64>();
+    this->header = trace::Header();
+    this->offset = 0;
+    this->previous = 0;
+    this->core = 0;
+    if (!this->file) {
+        auto sb = StringBuilder();
+        sb << "'" << path << "' could not be opened";
+        throw IoException(sb.str());
+    }
+
+    // Reserve space for the header (it is rewritten on close)
+    this->buffer.resize(trace::HEADER_SIZE);
+    this->buffer.reserve(consts::BLOCK_SIZE + trace::MAX_RECORD);
+}
+
+void Writer::write(const Record *records, u64 count) {
+    for (u64 i = 0; i < count; i++) {
+        // Every chunk restarts the delta chain (and the core) and gets an
+        // index entry
+        if (this->header.count % this->header.chunk_records == 0) {
+            this->index.push_back(this->offset + this->buffer.size());
+            this->previous = 0;
+            this->core = 0;
+        }
+        auto zigzag = trace::encode(this->previous, records[i].address);
+        auto switched = records[i].core != this->core;
+        auto size = this->buffer.size();
+        this->buffer.resize(size + trace::MAX_RECORD);
+        auto *end = trace::put_record(&this->buffer[size], zigzag, records[i].store, switched);
+        if (switched) {
+            end = trace::put_varint(end, records[i].core);
+        }
+        this->buffer.resize(end - this->buffer.data());
+        this->previous = records[i].address;
+        this->core = records[i].core;
+        this->header.count += 1;
+        if (this->buffer.size() >= consts::BLOCK_SIZE) {
+            this->flush();
+        }
+    }
+}
+
+void Writer::close() {
+    // Append the chunk index
+    this->header.index = this->offset + this->buffer.size();
+    for (auto entry: this->index) {
+        auto size = this->buffer.size();
+        this->buffer.resize(size + sizeof(u64));
+        trace::put_u64(&this->buffer[size], entry);
+    }
+    this->flush();
+
+    // Rewrite the header now that the counts are known
+    u8 header[trace::HEADER_SIZE];
+    this->header.encode(header);
+    this->file.seekp(0);
+    this->file.write((const char*)header, trace::HEADER_SIZE);
+    this->file.close();
+    if (!this->file) {
+        auto sb = StringBuilder();
+        sb << "'" << this->path << "' could not be written";
+        throw IoException(sb.str());
+    }
+}
+
+void Writer::flush() {
+    this->file.write((const char*)this->buffer.data(), this->buffer.size());
+    if (!this->file) {
+        auto sb = StringBuilder();
+        sb << "'" << this->path << "' could not be written";
+        throw IoException(sb.str());
+    }
+    this->offset += this->buffer.size();
+    this->buffer.clear();
+}
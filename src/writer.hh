@@ -0,0 +1,24 @@
+#pragma once
+#include "record.hh"
+#include "trace.hh"
+#include "types.hh"
+
+class Writer {
+    private:
+        String path;
+        FileWriter file;
+        Vector<u8> buffer;
+        Vector<u64> index;
+        trace::Header header;
+        u64 offset;
+        u64 previous;
+        u16 core;
+        void flush();
+
+    public:
+        Writer(const String&);
+        Writer(const Writer&) = delete;
+        Writer& operator=(const Writer&) = delete;
+        void write(const Record*, u64);
+        void close();
+};